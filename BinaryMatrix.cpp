@@ -0,0 +1,97 @@
+/* 
+ * File:   BinaryMatrix.cpp
+ * Author: Varun Srivastava
+ *
+ */
+
+#include <cstring>
+#include <fstream>
+
+#include "BinaryMatrix.h"
+
+static const char BINARY_MAGIC[8] = {'C', 'O', 'N', 'F', 'M', 'A', 'T', '\0'};
+static const std::uint32_t BINARY_VERSION = 1;
+static const std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+bool is_binary_matrix(const char *data, std::size_t size)
+{
+    return size >= sizeof(BinaryMatrixHeader) && std::memcmp(data, BINARY_MAGIC, sizeof(BINARY_MAGIC)) == 0;
+}
+
+std::string validate_binary_matrix(const char *data, std::size_t size)
+{
+    BinaryMatrixHeader header;
+    std::memcpy(&header, data, sizeof(header));
+
+    if (header.byte_order != BYTE_ORDER_MARK)
+        return "binary matrix was written with a different byte order";
+    if (header.version != BINARY_VERSION)
+        return "unsupported binary matrix version";
+    if (header.element_type > ELEMENT_FIXED16)
+        return "unsupported binary matrix element type";
+    if (header.layout > LAYOUT_UPPER_TRIANGLE)
+        return "unsupported binary matrix layout";
+    MatrixFormat format(static_cast<ElementType>(header.element_type), static_cast<MatrixLayout>(header.layout));
+    int stride = format.layout == LAYOUT_FULL ? DistanceMatrix::padded_stride(header.n, format.element) : header.n;
+    if (header.n < 0 || header.stride != stride)
+        return "corrupt binary matrix dimensions";
+    DistanceMatrix view(data + sizeof(header), header.n, header.stride, format, header.max_error);
+    if (size < sizeof(header) + view.bytes())
+        return "binary matrix is truncated";
+    return "";
+}
+
+BinaryMatrixWriter::BinaryMatrixWriter(const std::string &filename, int n, MatrixFormat format, double processing_time,
+                                       int papers_in_session, int parallel_tracks, int sessions_in_track, double tradeoff_coefficient)
+    : out(filename.c_str(), std::ios::binary), format(format)
+{
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+    header.version = BINARY_VERSION;
+    header.byte_order = BYTE_ORDER_MARK;
+    header.element_type = format.element;
+    header.layout = format.layout;
+    header.papers_in_session = papers_in_session;
+    header.parallel_tracks = parallel_tracks;
+    header.sessions_in_track = sessions_in_track;
+    header.processing_time = processing_time;
+    header.tradeoff_coefficient = tradeoff_coefficient;
+    header.n = n;
+    header.stride = format.layout == LAYOUT_FULL ? DistanceMatrix::padded_stride(n, format.element) : n;
+
+    // The error is only known once every row is encoded, finish() fills it in
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+}
+
+std::size_t BinaryMatrixWriter::row_bytes(int i) const
+{
+    int elements = format.layout == LAYOUT_FULL ? header.stride : header.n - i;
+    return elements * DistanceMatrix::element_bytes(format.element);
+}
+
+double BinaryMatrixWriter::encode_row(int i, const double *values, char *buffer) const
+{
+    int first = format.layout == LAYOUT_FULL ? 0 : i;
+    std::memset(buffer, 0, row_bytes(i)); // padding
+    return DistanceMatrix::encode(values + first, header.n - first, format.element, buffer);
+}
+
+bool BinaryMatrixWriter::finish(double max_error)
+{
+    header.max_error = max_error;
+    out.seekp(0);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.close();
+    return !out.fail();
+}
+
+bool write_binary_matrix(const std::string &filename, const DistanceMatrix &matrix, double processing_time,
+                         int papers_in_session, int parallel_tracks, int sessions_in_track, double tradeoff_coefficient)
+{
+    BinaryMatrixWriter writer(filename, matrix.size(), matrix.get_format(), processing_time, papers_in_session,
+                              parallel_tracks, sessions_in_track, tradeoff_coefficient);
+    if (!writer.is_open())
+        return false;
+    writer.write(static_cast<const char *>(matrix.raw()), matrix.bytes());
+    return writer.finish(matrix.max_error());
+}
@@ -0,0 +1,85 @@
+/* 
+ * File:   BinaryMatrix.h
+ * Author: Varun Srivastava
+ *
+ */
+
+#ifndef BINARYMATRIX_H
+#define BINARYMATRIX_H
+
+#include <cstdint>
+#include <cstddef>
+#include <fstream>
+#include <string>
+
+#include "DistanceMatrix.h"
+
+/**
+ * On disk layout of a binary input file. The 64 byte header is followed by
+ * the distance matrix block exactly as DistanceMatrix stores it (padded full
+ * rows or the packed upper triangle, in the stored element type), so a page
+ * aligned mapping of the file can be used as a DistanceMatrix directly.
+ * Fields are stored in host byte order, `byte_order` guards against reading
+ * a file written on a machine of the other endianness.
+ */
+struct BinaryMatrixHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t byte_order;
+  std::uint16_t element_type;
+  std::uint16_t layout;
+  std::int32_t papers_in_session;
+  std::int32_t parallel_tracks;
+  std::int32_t sessions_in_track;
+  double processing_time;
+  double tradeoff_coefficient;
+  std::int32_t n;
+  std::int32_t stride;
+  double max_error; // largest error introduced by the stored precision
+};
+
+static_assert(sizeof(BinaryMatrixHeader) == DistanceMatrix::ALIGNMENT, "header must keep the rows aligned");
+
+// True if the mapped bytes start with a binary matrix header
+bool is_binary_matrix(const char *data, std::size_t size);
+
+// Returns an empty string if the header and the file size are consistent, otherwise the reason they are not
+std::string validate_binary_matrix(const char *data, std::size_t size);
+
+// Writes the matrix in its stored format and the conference parameters, returns false if the file cannot be written
+bool write_binary_matrix(const std::string &filename, const DistanceMatrix &matrix, double processing_time,
+                         int papers_in_session, int parallel_tracks, int sessions_in_track, double tradeoff_coefficient);
+
+/**
+ * Writes a binary input file row by row, for matrices that are produced on
+ * the fly and never held in memory as a whole. Rows can be encoded
+ * independently, e.g. by several threads, but have to be written in order.
+ */
+class BinaryMatrixWriter
+{
+private:
+  std::ofstream out;
+  BinaryMatrixHeader header;
+  MatrixFormat format;
+
+public:
+  BinaryMatrixWriter(const std::string &filename, int n, MatrixFormat format, double processing_time,
+                     int papers_in_session, int parallel_tracks, int sessions_in_track, double tradeoff_coefficient);
+
+  bool is_open() const { return out.is_open(); }
+
+  // Bytes row i takes in the file
+  std::size_t row_bytes(int i) const;
+
+  // Encodes row i, given as n doubles, into row_bytes(i) bytes at buffer, returns the largest rounding error
+  double encode_row(int i, const double *values, char *buffer) const;
+
+  // Appends encoded rows
+  void write(const char *data, std::size_t bytes) { out.write(data, bytes); }
+
+  // Completes the header with the error of the stored precision, returns false if anything failed to be written
+  bool finish(double max_error);
+};
+
+#endif /* BINARYMATRIX_H */
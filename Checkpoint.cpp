@@ -0,0 +1,194 @@
+/*
+ * File:   Checkpoint.cpp
+ * Author: Varun Srivastava
+ *
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "Checkpoint.h"
+
+static const char CHECKPOINT_MAGIC[8] = {'C', 'O', 'N', 'F', 'C', 'K', 'P', 'T'};
+static const std::uint32_t CHECKPOINT_VERSION = 1;
+static const std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+// Fixed part of the file, followed by the workers one after another
+struct CheckpointHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t byte_order;
+  std::int32_t papers_in_session;
+  std::int32_t parallel_tracks;
+  std::int32_t sessions_in_track;
+  std::int32_t workers;
+  double elapsed;
+};
+
+template <typename T>
+static void put(std::ofstream &out, const T &value)
+{
+    out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template <typename T>
+static void put_array(std::ofstream &out, const T *values, std::uint32_t count)
+{
+    put(out, count);
+    out.write(reinterpret_cast<const char *>(values), sizeof(T) * count);
+}
+
+template <typename T>
+static bool get(std::ifstream &in, T &value)
+{
+    return static_cast<bool>(in.read(reinterpret_cast<char *>(&value), sizeof(value)));
+}
+
+// Reads a length prefixed array of at most limit elements
+template <typename T>
+static bool get_array(std::ifstream &in, std::vector<T> &values, std::uint32_t limit)
+{
+    std::uint32_t count;
+    if (!get(in, count) || count > limit)
+        return false;
+    values.resize(count);
+    return count == 0 || static_cast<bool>(in.read(reinterpret_cast<char *>(values.data()), sizeof(T) * count));
+}
+
+bool write_checkpoint(const std::string &filename, const Checkpoint &checkpoint)
+{
+    std::string temporary = filename + ".tmp";
+    std::ofstream out(temporary.c_str(), std::ios::binary);
+    if (!out)
+        return false;
+
+    CheckpointHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    header.version = CHECKPOINT_VERSION;
+    header.byte_order = BYTE_ORDER_MARK;
+    header.papers_in_session = checkpoint.papers_in_session;
+    header.parallel_tracks = checkpoint.parallel_tracks;
+    header.sessions_in_track = checkpoint.sessions_in_track;
+    header.workers = checkpoint.workers.size();
+    header.elapsed = checkpoint.elapsed;
+    put(out, header);
+    for (const WorkerCheckpoint &worker : checkpoint.workers)
+    {
+        put(out, worker.iterations);
+        put(out, worker.stall);
+        put(out, worker.best_score);
+        put_array(out, worker.state.data(), worker.state.size());
+        put_array(out, worker.best_state.data(), worker.best_state.size());
+        put_array(out, worker.rng.data(), worker.rng.size());
+    }
+    out.close();
+    if (out.fail())
+        return false;
+    return std::rename(temporary.c_str(), filename.c_str()) == 0;
+}
+
+std::string read_checkpoint(const std::string &filename, Checkpoint &checkpoint)
+{
+    std::ifstream in(filename.c_str(), std::ios::binary);
+    if (!in)
+        return "unable to open checkpoint file " + filename;
+
+    CheckpointHeader header;
+    if (!get(in, header) || std::memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0)
+        return "not a checkpoint file";
+    if (header.byte_order != BYTE_ORDER_MARK)
+        return "checkpoint was written with a different byte order";
+    if (header.version != CHECKPOINT_VERSION)
+        return "unsupported checkpoint version";
+    if (header.papers_in_session <= 0 || header.parallel_tracks <= 0 || header.sessions_in_track <= 0 || header.workers <= 0)
+        return "corrupt checkpoint dimensions";
+
+    checkpoint.papers_in_session = header.papers_in_session;
+    checkpoint.parallel_tracks = header.parallel_tracks;
+    checkpoint.sessions_in_track = header.sessions_in_track;
+    checkpoint.elapsed = header.elapsed;
+    checkpoint.workers.assign(header.workers, WorkerCheckpoint());
+    const std::uint32_t n = static_cast<std::uint32_t>(header.papers_in_session) * header.parallel_tracks * header.sessions_in_track;
+    std::vector<char> rng;
+    for (WorkerCheckpoint &worker : checkpoint.workers)
+    {
+        if (!get(in, worker.iterations) || !get(in, worker.stall) || !get(in, worker.best_score) || !get_array(in, worker.state, n) ||
+            !get_array(in, worker.best_state, n) || !get_array(in, rng, 1 << 16))
+            return "checkpoint is truncated";
+        if ((!worker.state.empty() && worker.state.size() != n) || (!worker.best_state.empty() && worker.best_state.size() != n))
+            return "corrupt checkpoint state";
+        worker.rng.assign(rng.begin(), rng.end());
+    }
+    return "";
+}
+
+CheckpointWriter::CheckpointWriter(const std::string &filename, double period, const Checkpoint &initial)
+    : filename(filename), period(period), start(Clock::now()), elapsed_before(initial.elapsed), latest(initial),
+      waiting(initial.workers.size(), 0), retired(initial.workers.size(), 0), outstanding(0), stopping(false), generation(0)
+{
+    thread = std::thread(&CheckpointWriter::run, this);
+}
+
+CheckpointWriter::~CheckpointWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    thread.join();
+}
+
+void CheckpointWriter::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!wake.wait_for(lock, period, [this]() { return stopping; }))
+    {
+        // Ask the running workers for a snapshot and give them up to a period to hand it in
+        outstanding = 0;
+        for (std::size_t w = 0; w != waiting.size(); ++w)
+        {
+            waiting[w] = !retired[w];
+            outstanding += waiting[w];
+        }
+        generation.fetch_add(1, std::memory_order_relaxed);
+        if (wake.wait_for(lock, period, [this]() { return stopping || outstanding == 0; }) && stopping)
+            break;
+
+        Checkpoint snapshot = latest;
+        snapshot.elapsed = elapsed_before + std::chrono::duration_cast<std::chrono::duration<double>>(Clock::now() - start).count();
+        lock.unlock();
+        if (!write_checkpoint(filename, snapshot))
+            std::cout << "Unable to write checkpoint file " << filename << std::endl;
+        lock.lock();
+    }
+}
+
+void CheckpointWriter::publish(int worker, WorkerCheckpoint &&snapshot)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    latest.workers[worker] = std::move(snapshot);
+    if (waiting[worker])
+    {
+        waiting[worker] = 0;
+        if (--outstanding == 0)
+            wake.notify_all();
+    }
+}
+
+void CheckpointWriter::retire(int worker)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    retired[worker] = 1;
+    if (waiting[worker])
+    {
+        waiting[worker] = 0;
+        if (--outstanding == 0)
+            wake.notify_all();
+    }
+}
@@ -0,0 +1,102 @@
+/*
+ * File:   Checkpoint.h
+ * Author: Varun Srivastava
+ *
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Where one search worker was. The aggregates of the state are not
+// stored, they are rebuilt from it on resume.
+struct WorkerCheckpoint
+{
+  std::vector<int> state;      // current state, empty if the worker had not started
+  std::vector<int> best_state; // best state of finished restarts, empty if there was none
+  double best_score = 0;
+  long long iterations = 0; // moves counted by the worker's budget
+  long long stall = 0;      // moves since the current state last improved
+  std::string rng;          // random engine as written by operator<<
+};
+
+// Where a whole search was
+struct Checkpoint
+{
+  int parallel_tracks = 0;
+  int sessions_in_track = 0;
+  int papers_in_session = 0;
+  double elapsed = 0; // seconds of the time budget used
+  std::vector<WorkerCheckpoint> workers;
+};
+
+// Writes the checkpoint to a temporary file renamed over filename, so an
+// interrupted write leaves the previous checkpoint intact. Returns false if
+// the file cannot be written.
+bool write_checkpoint(const std::string &filename, const Checkpoint &checkpoint);
+
+// Returns an empty string if the file was read, otherwise the reason it was not
+std::string read_checkpoint(const std::string &filename, Checkpoint &checkpoint);
+
+/**
+ * CheckpointWriter saves a running search every period on a thread of its
+ * own. When a checkpoint is due it raises a generation counter, which the
+ * workers poll with a relaxed load between moves; each worker then hands
+ * in a copy of where it is, and the writer serializes and writes the
+ * copies while the workers carry on. Workers that have finished, or are
+ * late by more than a period, keep their previous snapshot.
+ */
+class CheckpointWriter
+{
+private:
+  typedef std::chrono::steady_clock Clock;
+
+  std::string filename;
+  std::chrono::duration<double> period;
+  Clock::time_point start;
+  double elapsed_before; // budget used before a resume
+
+  std::mutex mutex;
+  std::condition_variable wake;
+  Checkpoint latest;           // snapshots handed in, guarded by mutex
+  std::vector<char> waiting;   // workers that owe a snapshot of the current generation
+  std::vector<char> retired;   // workers that have stopped
+  int outstanding;
+  bool stopping;
+  std::atomic<long long> generation;
+  std::thread thread;
+
+  void run();
+
+public:
+  CheckpointWriter(const std::string &filename, double period, const Checkpoint &initial);
+  ~CheckpointWriter();
+
+  CheckpointWriter(const CheckpointWriter &) = delete;
+  CheckpointWriter &operator=(const CheckpointWriter &) = delete;
+
+  // True once per generation when a snapshot is due, seen is the worker's last generation
+  bool wanted(long long &seen) const
+  {
+    long long current = generation.load(std::memory_order_relaxed);
+    if (current == seen)
+      return false;
+    seen = current;
+    return true;
+  }
+
+  // Hands in where a worker is
+  void publish(int worker, WorkerCheckpoint &&snapshot);
+
+  // Marks a worker as stopped, the writer no longer waits for it
+  void retire(int worker);
+};
+
+#endif /* CHECKPOINT_H */
@@ -4,6 +4,8 @@
  * 
  */
 
+#include <utility>
+
 #include "Conference.h"
 
 Conference::Conference()
@@ -15,38 +17,28 @@ Conference::Conference()
 
 Conference::Conference(int parallelTracks, int sessionsInTrack, int papersInSession)
 {
-    this->parallelTracks = parallelTracks;
-    this->sessionsInTrack = sessionsInTrack;
-    this->papersInSession = papersInSession;
     initTracks(parallelTracks, sessionsInTrack, papersInSession);
 }
 
 void Conference::initTracks(int parallelTracks, int sessionsInTrack, int papersInSession)
 {
-    tracks = (Track *)malloc(sizeof(Track) * parallelTracks);
-    for (int i = 0; i < parallelTracks; i++)
-    {
-        Track tempTrack(sessionsInTrack);
-        for (int j = 0; j < sessionsInTrack; j++)
-        {
-            Session tempSession(papersInSession);
-            tempTrack.setSession(j, tempSession);
-        }
-        tracks[i] = tempTrack;
-    }
+    this->parallelTracks = parallelTracks;
+    this->sessionsInTrack = sessionsInTrack;
+    this->papersInSession = papersInSession;
+    schedule.assign(static_cast<size_t>(parallelTracks) * sessionsInTrack * papersInSession, -1);
 }
 
-int Conference::getParallelTracks()
+int Conference::getParallelTracks() const
 {
     return parallelTracks;
 }
 
-int Conference::getSessionsInTrack()
+int Conference::getSessionsInTrack() const
 {
     return sessionsInTrack;
 }
 
-int Conference::getPapersInSession()
+int Conference::getPapersInSession() const
 {
     return papersInSession;
 }
@@ -55,7 +47,8 @@ Track Conference::getTrack(int index)
 {
     if (index < parallelTracks)
     {
-        return tracks[index];
+        return Track(schedule.data() + static_cast<size_t>(index) * papersInSession, sessionsInTrack, papersInSession,
+                     parallelTracks * papersInSession);
     }
     else
     {
@@ -64,12 +57,26 @@ Track Conference::getTrack(int index)
     }
 }
 
+const vector<int> &Conference::getSchedule() const
+{
+    return schedule;
+}
+
+void Conference::setSchedule(vector<int> schedule)
+{
+    if (schedule.size() != this->schedule.size())
+    {
+        cout << "Schedule size mismatch - Conference::setSchedule" << endl;
+        exit(0);
+    }
+    this->schedule = std::move(schedule);
+}
+
 void Conference::setPaper(int trackIndex, int sessionIndex, int paperIndex, int paperId)
 {
     if (this->parallelTracks > trackIndex)
     {
-        Track curTrack = tracks[trackIndex];
-        curTrack.setPaper(sessionIndex, paperIndex, paperId);
+        getTrack(trackIndex).setPaper(sessionIndex, paperIndex, paperId);
     }
     else
     {
@@ -78,17 +85,18 @@ void Conference::setPaper(int trackIndex, int sessionIndex, int paperIndex, int
     }
 }
 
-void Conference::printConference(char *filename)
+void Conference::printConference(char *filename) const
 {
     ofstream ofile(filename);
 
+    const int *paper = schedule.data();
     for (int i = 0; i < sessionsInTrack; i++)
     {
         for (int j = 0; j < parallelTracks; j++)
         {
             for (int k = 0; k < papersInSession; k++)
             {
-                ofile << tracks[j].getSession(i).getPaper(k) << " ";
+                ofile << *paper++ << " ";
             }
             if (j != parallelTracks - 1)
             {
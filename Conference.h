@@ -10,15 +10,22 @@
 
 #include <iostream>
 #include <fstream>
+#include <vector>
 using namespace std;
 
 #include "Track.h"
 
+/**
+ * Conference stores the schedule as one flat array of paper ids, time slot
+ * by time slot, track by track within a slot and paper by paper within a
+ * session; the same layout as the search state of HillClimb. Tracks and
+ * sessions are views into it.
+ */
 class Conference
 {
   private:
-    // The array of tracks.
-    Track *tracks;
+    // Paper ids, entry (slot * parallelTracks + track) * papersInSession + paper.
+    vector<int> schedule;
 
     // The number of parallel tracks.
     int parallelTracks;
@@ -42,7 +49,7 @@ class Conference
     Conference(int parallelTracks, int sessionsInTrack, int papersInSession);
 
     /**
-     * Initialize the tracks.
+     * Initialize an empty schedule of the given shape.
      * @param parallelTracks is the number of parallel tracks.
      * @param sessionsInTrack is the number of sessions in a track.
      * @param papersInSession is the number of papers in a session.
@@ -53,27 +60,39 @@ class Conference
      * Gets the number of parallel tracks.
      * @return the number of parallel tracks.
      */
-    int getParallelTracks();
+    int getParallelTracks() const;
 
     /**
      * Gets the number of sessions in a track.
      * @return the number of sessions in a track.
      */
-    int getSessionsInTrack();
+    int getSessionsInTrack() const;
 
     /**
      * Gets the number of papers in a session.
      * @return the number of papers in a session.
      */
-    int getPapersInSession();
+    int getPapersInSession() const;
 
     /**
      * Gets the track at the specified index.
      * @param index is the index of the specified track.
-     * @return the track
+     * @return a view of the track
      */
     Track getTrack(int index);
 
+    /**
+     * Gets the whole schedule.
+     * @return the paper ids in slot, track, paper order.
+     */
+    const vector<int> &getSchedule() const;
+
+    /**
+     * Replaces the whole schedule, e.g. by the state a search ended in.
+     * @param schedule holds the paper ids in slot, track, paper order.
+     */
+    void setSchedule(vector<int> schedule);
+
     /**
      * Sets the paper in the specified slot to the given paper id.
      * @param trackIndex is the track index.
@@ -83,7 +102,7 @@ class Conference
      */
     void setPaper(int trackIndex, int sessionIndex, int paperIndex, int paperId);
 
-    void printConference(char *);
+    void printConference(char *) const;
 };
 
 #endif /* CONFERENCE_H */
@@ -0,0 +1,442 @@
+/* 
+ * File:   DistanceMatrix.cpp
+ * Author: Varun Srivastava
+ *
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include "DistanceMatrix.h"
+#include "Kernels.h"
+
+bool parse_element_type(const char *name, ElementType &element)
+{
+    if (std::strcmp(name, "double") == 0)
+        element = ELEMENT_DOUBLE;
+    else if (std::strcmp(name, "float") == 0)
+        element = ELEMENT_FLOAT;
+    else if (std::strcmp(name, "fixed16") == 0)
+        element = ELEMENT_FIXED16;
+    else
+        return false;
+    return true;
+}
+
+bool parse_feature_metric(const char *name, FeatureMetric &metric)
+{
+    if (std::strcmp(name, "cosine") == 0)
+        metric = METRIC_COSINE;
+    else if (std::strcmp(name, "euclidean") == 0)
+        metric = METRIC_EUCLIDEAN;
+    else
+        return false;
+    return true;
+}
+
+/*
+ * Direct mapped cache of feature rows: row i can only be kept in slot
+ * i % rows. Slots are taken with a try lock, a thread that finds its slot
+ * busy computes the row without the cache instead of waiting.
+ */
+struct DistanceMatrix::RowCache
+{
+    int rows;
+    std::vector<int> ids;       // row kept in each slot, -1 if none
+    std::vector<double> values; // rows x n distances
+    std::unique_ptr<std::atomic<bool>[]> busy;
+
+    RowCache(int rows, int n) : rows(rows), ids(rows, -1), values(static_cast<std::size_t>(rows) * n), busy(new std::atomic<bool>[rows]())
+    {
+    }
+};
+
+DistanceMatrix::DistanceMatrix()
+    : data(nullptr), n(0), stride(0), owned(true), error(0), dimensions(0), metric(METRIC_COSINE), norms(nullptr), linear(false),
+      offsets(nullptr), adjacent(nullptr), adjacent_distances(nullptr), default_distance(0)
+{
+}
+
+DistanceMatrix::DistanceMatrix(int n, MatrixFormat format)
+    : data(nullptr), n(n), stride(format.layout == LAYOUT_FULL ? padded_stride(n, format.element) : n),
+      format(format), owned(true), error(0), dimensions(0), metric(METRIC_COSINE), norms(nullptr), linear(false),
+      offsets(nullptr), adjacent(nullptr), adjacent_distances(nullptr), default_distance(0)
+{
+    // Round up so the allocation is a whole number of cache lines
+    std::size_t size = (bytes() + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    void *block = nullptr;
+    if (size && posix_memalign(&block, ALIGNMENT, size) != 0)
+    {
+        std::cout << "Unable to allocate distance matrix of " << n << " papers" << std::endl;
+        exit(0);
+    }
+    data = block;
+    if (data)
+        std::memset(data, 0, size);
+}
+
+DistanceMatrix::DistanceMatrix(const void *data, int n, int stride, MatrixFormat format, double error)
+    : data(const_cast<void *>(data)), n(n), stride(stride), format(format), owned(false), error(error),
+      dimensions(0), metric(METRIC_COSINE), norms(nullptr), linear(false),
+      offsets(nullptr), adjacent(nullptr), adjacent_distances(nullptr), default_distance(0)
+{
+}
+
+DistanceMatrix::DistanceMatrix(int n, int dimensions, FeatureMetric metric)
+    : data(nullptr), n(n), stride(padded_stride(dimensions, ELEMENT_FLOAT)), format(ELEMENT_FLOAT, LAYOUT_FULL), owned(true),
+      error(0), dimensions(dimensions), metric(metric), norms(nullptr), linear(false),
+      offsets(nullptr), adjacent(nullptr), adjacent_distances(nullptr), default_distance(0)
+{
+    std::size_t size = (bytes() + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    void *block = nullptr;
+    if (size && posix_memalign(&block, ALIGNMENT, size) != 0)
+    {
+        std::cout << "Unable to allocate feature vectors of " << n << " papers" << std::endl;
+        exit(0);
+    }
+    data = block;
+    if (data)
+        std::memset(data, 0, size);
+    if (data && metric == METRIC_EUCLIDEAN)
+        norms = static_cast<float *>(data) + static_cast<std::size_t>(n) * stride;
+}
+
+DistanceMatrix::DistanceMatrix(int n, double default_distance, const std::vector<std::vector<Neighbour>> &neighbours)
+    : DistanceMatrix()
+{
+    this->n = n;
+    this->default_distance = default_distance;
+
+    // Every listed pair is stored in the rows of both papers, duplicates are dropped after sorting
+    std::vector<std::int64_t> counts(n + 1, 0);
+    for (int i = 0; i < n; ++i)
+        for (const Neighbour &neighbour : neighbours[i])
+            if (neighbour.paper != i)
+            {
+                ++counts[i + 1];
+                ++counts[neighbour.paper + 1];
+            }
+    for (int i = 0; i < n; ++i)
+        counts[i + 1] += counts[i];
+    const std::int64_t listed = counts[n];
+
+    std::size_t size = (bytes_of_sparse(n, listed) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    void *block = nullptr;
+    if (posix_memalign(&block, ALIGNMENT, size) != 0)
+    {
+        std::cout << "Unable to allocate the neighbours of " << n << " papers" << std::endl;
+        exit(0);
+    }
+    data = block;
+    offsets = static_cast<std::int64_t *>(data);
+    adjacent_distances = reinterpret_cast<double *>(offsets + n + 1);
+    adjacent = reinterpret_cast<int *>(adjacent_distances + listed);
+
+    std::vector<std::int64_t> fill(counts.begin(), counts.end() - 1);
+    for (int i = 0; i < n; ++i)
+        for (const Neighbour &neighbour : neighbours[i])
+            if (neighbour.paper != i)
+            {
+                adjacent[fill[i]] = neighbour.paper;
+                adjacent_distances[fill[i]++] = neighbour.distance;
+                adjacent[fill[neighbour.paper]] = i;
+                adjacent_distances[fill[neighbour.paper]++] = neighbour.distance;
+            }
+
+    // Sort every row by paper and keep the smallest distance of each, compacting the rows in place
+    std::vector<Neighbour> row;
+    std::int64_t kept = 0;
+    for (int i = 0; i < n; ++i)
+    {
+        row.clear();
+        for (std::int64_t e = counts[i]; e != counts[i + 1]; ++e)
+            row.push_back(Neighbour{adjacent[e], adjacent_distances[e]});
+        std::sort(row.begin(), row.end(), [](const Neighbour &a, const Neighbour &b) {
+            return a.paper != b.paper ? a.paper < b.paper : a.distance < b.distance;
+        });
+        offsets[i] = kept;
+        for (std::size_t e = 0; e != row.size(); ++e)
+            if (e == 0 || row[e].paper != row[e - 1].paper)
+            {
+                adjacent[kept] = row[e].paper;
+                adjacent_distances[kept++] = row[e].distance;
+            }
+    }
+    offsets[n] = kept;
+    if (kept != listed)
+        std::memmove(adjacent_distances + kept, adjacent, kept * sizeof(int));
+    adjacent = reinterpret_cast<int *>(adjacent_distances + kept);
+}
+
+std::size_t DistanceMatrix::bytes_of_sparse(int n, std::int64_t listed)
+{
+    return (n + 1) * sizeof(std::int64_t) + listed * (sizeof(double) + sizeof(int));
+}
+
+DistanceMatrix::~DistanceMatrix()
+{
+    if (owned)
+        free(data);
+}
+
+int DistanceMatrix::padded_stride(int n, ElementType element)
+{
+    const int per_line = ALIGNMENT / element_bytes(element);
+    return (n + per_line - 1) / per_line * per_line;
+}
+
+std::size_t DistanceMatrix::element_bytes(ElementType element)
+{
+    switch (element)
+    {
+    case ELEMENT_FLOAT:
+        return sizeof(float);
+    case ELEMENT_FIXED16:
+        return sizeof(std::uint16_t);
+    default:
+        return sizeof(double);
+    }
+}
+
+double DistanceMatrix::encode(const double *values, int count, ElementType element, void *out)
+{
+    double worst = 0;
+    for (int j = 0; j < count; ++j)
+    {
+        double stored;
+        if (element == ELEMENT_DOUBLE)
+            stored = static_cast<double *>(out)[j] = values[j];
+        else if (element == ELEMENT_FLOAT)
+            stored = static_cast<float *>(out)[j] = static_cast<float>(values[j]);
+        else
+        {
+            double clamped = std::min(1.0, std::max(0.0, values[j]));
+            std::uint16_t q = static_cast<std::uint16_t>(std::lround(clamped * 65535));
+            static_cast<std::uint16_t *>(out)[j] = q;
+            stored = q * (1.0 / 65535);
+        }
+        worst = std::max(worst, std::fabs(stored - values[j]));
+    }
+    return worst;
+}
+
+std::size_t DistanceMatrix::bytes() const
+{
+    if (dimensions)
+        return (static_cast<std::size_t>(n) * stride + (metric == METRIC_EUCLIDEAN ? n : 0)) * sizeof(float);
+    if (offsets)
+        return bytes_of_sparse(n, offsets[n]);
+    std::size_t elements = format.layout == LAYOUT_FULL ? static_cast<std::size_t>(n) * stride
+                                                        : static_cast<std::size_t>(n) * (n + 1) / 2;
+    return elements * element_bytes(format.element);
+}
+
+void DistanceMatrix::finish_features()
+{
+    const Kernels &k = kernels();
+    linear = metric == METRIC_COSINE;
+    for (int i = 0; i < n; ++i)
+    {
+        float *vector = features(i);
+        for (int j = 0; j < dimensions && linear; ++j)
+            linear = vector[j] >= 0;
+        double squared;
+        k.dots(&squared, vector, vector, 0, 1, stride);
+        if (metric == METRIC_EUCLIDEAN)
+            norms[i] = static_cast<float>(squared);
+        else if (squared > 0)
+        {
+            // Unit vectors turn the cosine similarity into a plain dot product
+            float scale = static_cast<float>(1 / std::sqrt(squared));
+            for (int j = 0; j < dimensions; ++j)
+                vector[j] *= scale;
+        }
+    }
+}
+
+void DistanceMatrix::set_row_cache(int rows)
+{
+    if (dimensions && rows > 0)
+        cache.reset(new RowCache(std::min(rows, n), n));
+    else
+        cache.reset();
+}
+
+DistanceMatrix DistanceMatrix::view() const
+{
+    DistanceMatrix shared(data, n, stride, format, error);
+    shared.dimensions = dimensions;
+    shared.metric = metric;
+    shared.norms = norms;
+    shared.linear = linear;
+    shared.offsets = offsets;
+    shared.adjacent = adjacent;
+    shared.adjacent_distances = adjacent_distances;
+    shared.default_distance = default_distance;
+    shared.cache = cache;
+    return shared;
+}
+
+double DistanceMatrix::sparse_distance(int i, int j) const
+{
+    if (i == j)
+        return 0;
+    const int *first = adjacent + offsets[i], *last = adjacent + offsets[i + 1];
+    const int *at = std::lower_bound(first, last, j);
+    return at != last && *at == j ? adjacent_distances[at - adjacent] : default_distance;
+}
+
+// Distance of papers i and j given the dot product of their feature vectors. Linear matrices are not
+// clipped, rounding may take a distance just out of [0, 1] but sums over sets of papers stay exact.
+static inline double feature_transform(FeatureMetric metric, bool linear, double dot, double norm_i, double norm_j)
+{
+    if (linear)
+        return 1 - dot;
+    double d = metric == METRIC_COSINE ? 1 - dot : std::sqrt(std::max(0.0, norm_i + norm_j - 2 * dot));
+    return std::min(1.0, std::max(0.0, d));
+}
+
+double DistanceMatrix::feature_distance(int i, int j) const
+{
+    if (i == j)
+        return 0;
+    const float *features = static_cast<const float *>(data);
+    double dot;
+    kernels().dots(&dot, features + static_cast<std::size_t>(i) * stride, features + static_cast<std::size_t>(j) * stride, 0, 1, stride);
+    return feature_transform(metric, linear, dot, norms ? norms[i] : 0, norms ? norms[j] : 0);
+}
+
+void DistanceMatrix::compute_feature_row(int i, double *buffer) const
+{
+    // The same kernel as a single distance, so a row agrees with operator() to the last bit
+    const float *features = static_cast<const float *>(data);
+    kernels().dots(buffer, features + static_cast<std::size_t>(i) * stride, features, stride, n, stride);
+    for (int j = 0; j < n; ++j)
+        buffer[j] = feature_transform(metric, linear, buffer[j], norms ? norms[i] : 0, norms ? norms[j] : 0);
+    buffer[i] = 0;
+}
+
+const double *DistanceMatrix::row(int i, double *buffer) const
+{
+    if (dimensions)
+    {
+        if (!cache)
+        {
+            compute_feature_row(i, buffer);
+            return buffer;
+        }
+        int slot = i % cache->rows;
+        bool expected = false;
+        if (!cache->busy[slot].compare_exchange_strong(expected, true, std::memory_order_acquire))
+        {
+            compute_feature_row(i, buffer);
+            return buffer;
+        }
+        double *kept = cache->values.data() + static_cast<std::size_t>(slot) * n;
+        if (cache->ids[slot] != i)
+        {
+            compute_feature_row(i, kept);
+            cache->ids[slot] = i;
+        }
+        std::memcpy(buffer, kept, n * sizeof(double));
+        cache->busy[slot].store(false, std::memory_order_release);
+        return buffer;
+    }
+
+    if (offsets)
+    {
+        std::fill(buffer, buffer + n, default_distance);
+        for (std::int64_t e = offsets[i]; e != offsets[i + 1]; ++e)
+            buffer[adjacent[e]] = adjacent_distances[e];
+        buffer[i] = 0;
+        return buffer;
+    }
+
+    if (is_direct())
+        return static_cast<const double *>(data) + static_cast<std::size_t>(i) * stride;
+
+    if (format.layout == LAYOUT_FULL)
+    {
+        std::size_t start = static_cast<std::size_t>(i) * stride;
+        if (format.element == ELEMENT_FLOAT)
+        {
+            const float *values = static_cast<const float *>(data) + start;
+            for (int j = 0; j < n; ++j)
+                buffer[j] = values[j];
+        }
+        else
+        {
+            const std::uint16_t *values = static_cast<const std::uint16_t *>(data) + start;
+            for (int j = 0; j < n; ++j)
+                buffer[j] = values[j] * (1.0 / 65535);
+        }
+        return buffer;
+    }
+
+    // The left part of row i is column i of the rows above it
+    for (int j = 0; j < i; ++j)
+        buffer[j] = (*this)(j, i);
+    std::size_t start = triangle_row(i);
+    if (format.element == ELEMENT_DOUBLE)
+        std::memcpy(buffer + i, static_cast<const double *>(data) + start, (n - i) * sizeof(double));
+    else if (format.element == ELEMENT_FLOAT)
+    {
+        const float *values = static_cast<const float *>(data) + start;
+        for (int j = i; j < n; ++j)
+            buffer[j] = values[j - i];
+    }
+    else
+    {
+        const std::uint16_t *values = static_cast<const std::uint16_t *>(data) + start;
+        for (int j = i; j < n; ++j)
+            buffer[j] = values[j - i] * (1.0 / 65535);
+    }
+    return buffer;
+}
+
+double DistanceMatrix::set_row(int i, const double *values)
+{
+    int first = format.layout == LAYOUT_FULL ? 0 : i;
+    char *start = static_cast<char *>(data) + offset(i, first) * element_bytes(format.element);
+    return encode(values + first, n - first, format.element, start);
+}
+
+DistanceMatrix::DistanceMatrix(DistanceMatrix &&other)
+    : data(other.data), n(other.n), stride(other.stride), format(other.format), owned(other.owned), error(other.error),
+      dimensions(other.dimensions), metric(other.metric), norms(other.norms), linear(other.linear), cache(std::move(other.cache)),
+      offsets(other.offsets), adjacent(other.adjacent), adjacent_distances(other.adjacent_distances), default_distance(other.default_distance)
+{
+    other.data = nullptr;
+    other.n = other.stride = other.dimensions = 0;
+    other.norms = nullptr;
+    other.offsets = nullptr;
+    other.adjacent = nullptr;
+    other.adjacent_distances = nullptr;
+    other.owned = true;
+}
+
+DistanceMatrix &DistanceMatrix::operator=(DistanceMatrix &&other)
+{
+    std::swap(data, other.data);
+    std::swap(n, other.n);
+    std::swap(stride, other.stride);
+    std::swap(format, other.format);
+    std::swap(owned, other.owned);
+    std::swap(error, other.error);
+    std::swap(dimensions, other.dimensions);
+    std::swap(metric, other.metric);
+    std::swap(norms, other.norms);
+    std::swap(linear, other.linear);
+    std::swap(cache, other.cache);
+    std::swap(offsets, other.offsets);
+    std::swap(adjacent, other.adjacent);
+    std::swap(adjacent_distances, other.adjacent_distances);
+    std::swap(default_distance, other.default_distance);
+    return *this;
+}
@@ -0,0 +1,239 @@
+/* 
+ * File:   DistanceMatrix.h
+ * Author: Varun Srivastava
+ *
+ */
+
+#ifndef DISTANCEMATRIX_H
+#define DISTANCEMATRIX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// How a single distance is stored
+enum ElementType : std::uint16_t
+{
+  ELEMENT_DOUBLE = 0,
+  ELEMENT_FLOAT = 1,
+  ELEMENT_FIXED16 = 2 // d * 65535 rounded, distances are clamped to [0, 1]
+};
+
+// Which part of the matrix is stored
+enum MatrixLayout : std::uint16_t
+{
+  LAYOUT_FULL = 0,          // every row, padded to a whole cache line
+  LAYOUT_UPPER_TRIANGLE = 1 // d(i, j) for j >= i only, rows packed back to back
+};
+
+// Storage chosen for a matrix that is about to be read in
+struct MatrixFormat
+{
+  ElementType element;
+  MatrixLayout layout;
+
+  MatrixFormat(ElementType element = ELEMENT_DOUBLE, MatrixLayout layout = LAYOUT_FULL)
+      : element(element), layout(layout) {}
+};
+
+// Reads an element type by name (double, float or fixed16), returns false for unknown names
+bool parse_element_type(const char *name, ElementType &element);
+
+// How the distance of two papers is computed from their feature vectors
+enum FeatureMetric
+{
+  METRIC_COSINE = 0,   // 1 - cosine similarity, clipped to [0, 1]
+  METRIC_EUCLIDEAN = 1 // euclidean distance, clipped to [0, 1]
+};
+
+// Reads a feature metric by name (cosine or euclidean), returns false for unknown names
+bool parse_feature_metric(const char *name, FeatureMetric &metric);
+
+// A paper listed as near another one, with their distance
+struct Neighbour
+{
+  int paper;
+  double distance;
+};
+
+/**
+ * DistanceMatrix stores the n x n paper distances in one contiguous,
+ * cache line aligned, row major block. Every row is padded to a multiple
+ * of the cache line so that each row starts on an aligned boundary.
+ * The block is either owned or borrowed from memory kept alive elsewhere,
+ * e.g. a mapped binary matrix file.
+ *
+ * To save memory the distances can be stored as floats or 16 bit fixed
+ * point, and/or as the upper triangle only, in which case the matrix is
+ * symmetric by construction. max_error() is the largest difference between
+ * a stored distance and the value it was built from.
+ *
+ * Alternatively only a feature vector per paper is stored, n x d floats
+ * with rows padded like the matrix rows, and distances are computed from
+ * them when asked for: a single one with a dot product, a row with n. An
+ * optional direct mapped cache keeps recently computed rows.
+ *
+ * Or only the nearest neighbours of each paper are stored, in compressed
+ * sparse rows sorted by paper, and every pair that is not listed is at a
+ * default distance. The lists are made symmetric when the matrix is built.
+ */
+class DistanceMatrix
+{
+private:
+  void *data;
+  int n;
+  int stride; // row length in elements including padding, full layout only
+  MatrixFormat format;
+  bool owned;
+  double error;
+
+  int dimensions; // length of the feature vectors, 0 if distances are stored
+  FeatureMetric metric;
+  float *norms;   // squared norms of the feature vectors, euclidean metric only, owned with data
+  bool linear;    // cosine metric over vectors without negative components, see is_linear()
+
+  struct RowCache;
+  std::shared_ptr<RowCache> cache; // shared with the views of the matrix
+
+  std::int64_t *offsets; // neighbours of paper i are [offsets[i], offsets[i + 1]), null if not sparse, owned with data
+  int *adjacent;
+  double *adjacent_distances;
+  double default_distance; // of pairs that are not neighbours
+
+  double feature_distance(int i, int j) const;
+  double sparse_distance(int i, int j) const;
+
+  // Size of a sparse block with the given number of stored neighbours
+  static std::size_t bytes_of_sparse(int n, std::int64_t listed);
+  void compute_feature_row(int i, double *buffer) const;
+
+  std::size_t offset(int i, int j) const
+  {
+    if (format.layout == LAYOUT_FULL)
+      return static_cast<std::size_t>(i) * stride + j;
+    if (i > j)
+    {
+      int k = i;
+      i = j;
+      j = k;
+    }
+    return triangle_row(i) + (j - i);
+  }
+
+  std::size_t triangle_row(int i) const
+  {
+    return static_cast<std::size_t>(i) * n - static_cast<std::size_t>(i) * (i - 1) / 2;
+  }
+
+public:
+  // Bytes every row (and the block itself) is aligned to
+  static const int ALIGNMENT = 64;
+
+  DistanceMatrix();
+  explicit DistanceMatrix(int n, MatrixFormat format = MatrixFormat());
+  // Non owning view of an existing aligned block
+  DistanceMatrix(const void *data, int n, int stride, MatrixFormat format, double error);
+
+  // Distances computed from n feature vectors of the given length, filled in through features()
+  DistanceMatrix(int n, int dimensions, FeatureMetric metric);
+
+  // Sparse distances, neighbours[i] lists papers near paper i. A pair listed twice keeps the smaller distance.
+  DistanceMatrix(int n, double default_distance, const std::vector<std::vector<Neighbour>> &neighbours);
+  ~DistanceMatrix();
+
+  DistanceMatrix(const DistanceMatrix &) = delete;
+  DistanceMatrix &operator=(const DistanceMatrix &) = delete;
+  DistanceMatrix(DistanceMatrix &&);
+  DistanceMatrix &operator=(DistanceMatrix &&);
+
+  // Number of papers
+  int size() const { return n; }
+
+  // Distance between element i and the start of row i + 1
+  int get_stride() const { return stride; }
+
+  MatrixFormat get_format() const { return format; }
+
+  // True if rows are plain doubles that can be read in place
+  bool is_direct() const { return format.element == ELEMENT_DOUBLE && format.layout == LAYOUT_FULL && !dimensions && !offsets; }
+
+  // True if distances are computed from feature vectors
+  bool has_features() const { return dimensions != 0; }
+  int get_dimensions() const { return dimensions; }
+
+  // Writable feature vector of paper i, the padding past the dimensions has to stay zero
+  float *features(int i) { return static_cast<float *>(data) + static_cast<std::size_t>(i) * stride; }
+  const float *features(int i) const { return static_cast<const float *>(data) + static_cast<std::size_t>(i) * stride; }
+
+  // True if d(x, y) = 1 - x.y for the unit vectors of every pair x != y without clipping, which holds
+  // for the cosine metric when no vector has a negative component. A sum of distances to a set of
+  // papers is then the size of the set less a dot product with the sum of their vectors, to double
+  // rounding as the dot products are summed in double.
+  bool is_linear() const { return linear; }
+
+  // Prepares the metric once every feature vector is filled in
+  void finish_features();
+
+  // Keeps up to rows computed feature rows, 0 for none. Not for matrices that are in use,
+  // views taken before keep the cache they were given.
+  void set_row_cache(int rows);
+
+  // Non owning matrix over the storage and the row cache of this one, which has to outlive it
+  DistanceMatrix view() const;
+
+  // True if only the nearest neighbours of each paper are stored
+  bool is_sparse() const { return offsets != nullptr; }
+  double get_default_distance() const { return default_distance; }
+
+  // Neighbours of paper i sorted by paper, and their distances, sparse matrices only
+  int neighbour_count(int i) const { return static_cast<int>(offsets[i + 1] - offsets[i]); }
+  const int *neighbours(int i) const { return adjacent + offsets[i]; }
+  const double *neighbour_distances(int i) const { return adjacent_distances + offsets[i]; }
+
+  // Row length a full matrix of n papers is padded to
+  static int padded_stride(int n, ElementType element = ELEMENT_DOUBLE);
+
+  // Bytes a single stored distance takes
+  static std::size_t element_bytes(ElementType element);
+
+  // Stores count doubles as consecutive elements at out, returns the largest rounding error
+  static double encode(const double *values, int count, ElementType element, void *out);
+
+  // Size in bytes of the stored block
+  std::size_t bytes() const;
+  const void *raw() const { return data; }
+
+  // Largest absolute error introduced by storing the distances
+  double max_error() const { return error; }
+  void set_max_error(double e) { error = e; }
+
+  // Writable row, only for direct matrices
+  double *row(int i) { return static_cast<double *>(data) + static_cast<std::size_t>(i) * stride; }
+
+  // Row i as doubles, either in place or decoded into buffer (n elements)
+  const double *row(int i, double *buffer) const;
+
+  // Stores row i from n doubles, returns the largest rounding error of the row
+  double set_row(int i, const double *values);
+
+  double operator()(int i, int j) const
+  {
+    if (dimensions)
+      return feature_distance(i, j);
+    if (offsets)
+      return sparse_distance(i, j);
+    std::size_t at = offset(i, j);
+    switch (format.element)
+    {
+    case ELEMENT_FLOAT:
+      return static_cast<const float *>(data)[at];
+    case ELEMENT_FIXED16:
+      return static_cast<const std::uint16_t *>(data)[at] * (1.0 / 65535);
+    default:
+      return static_cast<const double *>(data)[at];
+    }
+  }
+};
+
+#endif /* DISTANCEMATRIX_H */
@@ -11,11 +11,16 @@
 #include <chrono>
 #include <iostream>
 #include <cmath>
+#include <limits>
+#include <thread>
+#include <memory>
+#include <sstream>
 
 #include "HillClimb.h"
+#include "Kernels.h"
+#include "ScheduleScorer.h"
 
-typedef std::chrono::high_resolution_clock Time;
-typedef std::chrono::duration<double> double_seconds;
+constexpr double HillClimb::SESSION_MOVE_SHARE;
 
 template <typename T>
 void print2dvector(const std::vector<std::vector<T>> vec)
@@ -37,63 +42,275 @@ void print1dvector(const std::vector<T> vec)
     std::cout << std::endl;
 }
 
-HillClimb::HillClimb(double **matrix, int p, int t, int k, int c)
+HillClimb::HillClimb(const DistanceMatrix &matrix, int p, int t, int k, double c)
 {
-    distance_matrix = matrix;
+    distance_matrix = &matrix;
     parallel_tracks = p;
     sessions_in_track = t;
     papers_in_session = k;
     trade_of_coefficient = c;
+    row_buffer_a.resize(matrix.size());
+    row_buffer_b.resize(matrix.size());
+    sparse = matrix.is_sparse();
+    summed = matrix.is_linear();
     dist = std::uniform_int_distribution<std::default_random_engine::result_type>(0, (papers_in_session * parallel_tracks * sessions_in_track) - 1);
+    session_share = std::bernoulli_distribution(sessions_in_track > 1 ? SESSION_MOVE_SHARE : 0.0);
 }
 
-void HillClimb::construct_session_matrix(State initial_state)
+void HillClimb::construct_session_matrix(const State &initial_state)
 {
-    if (session_distance_matrix.empty())
+    int n = parallel_tracks * sessions_in_track * papers_in_session;
+    int sessions = parallel_tracks * sessions_in_track;
+    if (sparse)
     {
-        session_distance_matrix.resize(sessions_in_track * parallel_tracks * papers_in_session);
-        for (auto &v : session_distance_matrix)
-            v.resize(parallel_tracks * sessions_in_track);
+        occupant = initial_state;
+        position.resize(n);
+        for (int i = 0; i != n; ++i)
+            position[initial_state[i]] = i;
+        return;
     }
-
-    auto sessions = state_to_sessions(initial_state);
-
-    for (size_t i = 0; i != session_distance_matrix.size(); ++i)
+    if (summed)
     {
-        for (size_t j = 0; j != sessions.size(); ++j)
+        const int d = distance_matrix->get_dimensions();
+        const int papers_in_time_slot = papers_in_session * parallel_tracks;
+        session_sums.assign(static_cast<size_t>(sessions) * d, 0.0);
+        slot_sums.assign(static_cast<size_t>(sessions_in_track) * d, 0.0);
+        self_dots.resize(n);
+        for (int i = 0; i != n; ++i)
         {
-            auto dist = 0.0;
-            for (const auto &e : sessions[j])
+            const float *x = distance_matrix->features(initial_state[i]);
+            double *session = session_sum(i / papers_in_session), *slot = slot_sum(i / papers_in_time_slot);
+            for (int j = 0; j != d; ++j)
             {
-                dist += distance_matrix[i][e];
+                session[j] += x[j];
+                slot[j] += x[j];
             }
-            session_distance_matrix[i][j] = dist;
+            kernels().dots(&self_dots[initial_state[i]], x, x, 0, 1, d);
+        }
+        return;
+    }
+    session_distance_matrix.assign(static_cast<size_t>(sessions) * n, 0.0);
+    slot_distance_matrix.assign(static_cast<size_t>(sessions_in_track) * n, 0.0);
+
+    // d(x, e) summed over e in session s is the sum of the rows of its papers
+    for (int s = 0; s != sessions; ++s)
+        for (int k = 0; k != papers_in_session; ++k)
+            kernels().accumulate(session_row(s), distance_matrix->row(initial_state[s * papers_in_session + k], row_buffer_a.data()), n);
+
+    for (int t = 0; t != sessions_in_track; ++t)
+        for (int i = 0; i != parallel_tracks; ++i)
+            kernels().accumulate(slot_row(t), session_row(t * parallel_tracks + i), n);
+
+    session_pair_matrix.assign(static_cast<size_t>(sessions) * sessions, 0.0);
+    for (int a = 0; a != sessions; ++a)
+        for (int k = 0; k != papers_in_session; ++k)
+        {
+            int x = initial_state[a * papers_in_session + k];
+            for (int b = 0; b != sessions; ++b)
+                session_pair(a, b) += session_row(b)[x];
         }
+}
+
+void HillClimb::refresh_session_pairs(int s, int a, int b, const State &state)
+{
+    double with_a = 0, with_b = 0;
+    for (int k = 0; k != papers_in_session; ++k)
+    {
+        int x = state[s * papers_in_session + k];
+        with_a += session_row(a)[x];
+        with_b += session_row(b)[x];
     }
+    session_pair(s, a) = session_pair(a, s) = with_a;
+    session_pair(s, b) = session_pair(b, s) = with_b;
 }
 
-std::vector<std::vector<int>> HillClimb::state_to_sessions(State state)
+State HillClimb::greedy_initialize()
 {
-    std::vector<std::vector<int>> blocks;
+    if (sparse)
+        return sparse_greedy_initialize();
+    int n = parallel_tracks * sessions_in_track * papers_in_session;
+    int sessions = parallel_tracks * sessions_in_track;
+    vector<double> growing; // the only session row a linear feature matrix keeps
+    if (summed)
+        growing.resize(n);
+    else
+        session_distance_matrix.assign(static_cast<size_t>(sessions) * n, 0.0);
 
-    for (auto it = state.cbegin(); it != state.cend(); it += papers_in_session)
-        blocks.push_back(std::vector<int>(it, it + papers_in_session));
+    // Grow each session from a random seed paper by repeatedly adding the
+    // unassigned paper closest to it. The session row holds the distance of
+    // every paper to the session so far.
+    State grouped;
+    grouped.reserve(n);
+    vector<int> unassigned(n);
+    std::iota(unassigned.begin(), unassigned.end(), 0);
+    for (int s = 0; s != sessions; ++s)
+    {
+        double *affinity = summed ? growing.data() : session_row(s);
+        std::fill(affinity, affinity + n, 0.0);
+        int pick = std::uniform_int_distribution<int>(0, unassigned.size() - 1)(rng);
+        for (int k = 0; k != papers_in_session; ++k)
+        {
+            if (k)
+            {
+                pick = 0;
+                for (size_t i = 1; i != unassigned.size(); ++i)
+                    if (affinity[unassigned[i]] < affinity[unassigned[pick]])
+                        pick = i;
+            }
+            int paper = unassigned[pick];
+            unassigned[pick] = unassigned.back();
+            unassigned.pop_back();
+            grouped.push_back(paper);
+            kernels().accumulate(affinity, distance_matrix->row(paper, row_buffer_a.data()), n);
+        }
+    }
+
+    // Distance between every pair of sessions, from their summed feature vectors for a linear feature matrix
+    vector<double> between, sums;
+    const int d = distance_matrix->get_dimensions();
+    if (summed)
+    {
+        sums.assign(static_cast<size_t>(sessions) * d, 0.0);
+        for (int i = 0; i != n; ++i)
+        {
+            const float *x = distance_matrix->features(grouped[i]);
+            for (int j = 0; j != d; ++j)
+                sums[static_cast<size_t>(i / papers_in_session) * d + j] += x[j];
+        }
+    }
+    else
+    {
+        between.assign(static_cast<size_t>(sessions) * sessions, 0.0);
+        for (int a = 0; a != sessions; ++a)
+            for (int b = 0; b != sessions; ++b)
+                for (int k = 0; k != papers_in_session; ++k)
+                    between[a * sessions + b] += session_row(b)[grouped[a * papers_in_session + k]];
+    }
+    auto distance_between = [&](int a, int b) {
+        if (!summed)
+            return between[static_cast<size_t>(a) * sessions + b];
+        double dot = 0;
+        for (int j = 0; j != d; ++j)
+            dot += sums[static_cast<size_t>(a) * d + j] * sums[static_cast<size_t>(b) * d + j];
+        return static_cast<double>(papers_in_session) * papers_in_session - dot;
+    };
 
-    return blocks;
+    // Fill each time slot with the sessions farthest from the ones already in it
+    State state;
+    state.reserve(n);
+    vector<double> spread(sessions, 0.0);
+    vector<bool> placed(sessions, false);
+    for (int t = 0; t != sessions_in_track; ++t)
+    {
+        std::fill(spread.begin(), spread.end(), 0.0);
+        for (int i = 0; i != parallel_tracks; ++i)
+        {
+            int choice = -1;
+            for (int s = 0; s != sessions; ++s)
+                if (!placed[s] && (choice < 0 || (i && spread[s] > spread[choice])))
+                    choice = s;
+            placed[choice] = true;
+            for (int s = 0; s != sessions; ++s)
+                if (!placed[s])
+                    spread[s] += distance_between(choice, s);
+            state.insert(state.end(), grouped.begin() + choice * papers_in_session, grouped.begin() + (choice + 1) * papers_in_session);
+        }
+    }
+    return state;
 }
 
-State HillClimb::greedy_initialize()
+State HillClimb::sparse_greedy_initialize()
 {
-    return State();
+    // greedy_initialize with the affinity D - d(x, e) to the listed neighbours e in place of the
+    // distance rows, every paper that is not listed has affinity 0
+    int n = parallel_tracks * sessions_in_track * papers_in_session;
+    int sessions = parallel_tracks * sessions_in_track;
+    const double D = distance_matrix->get_default_distance();
+
+    State grouped;
+    grouped.reserve(n);
+    vector<int> unassigned(n), slot_in_unassigned(n);
+    std::iota(unassigned.begin(), unassigned.end(), 0);
+    std::iota(slot_in_unassigned.begin(), slot_in_unassigned.end(), 0);
+    vector<double> affinity(n, 0.0);
+    vector<char> touched(n, 0);
+    vector<int> candidates;
+    for (int s = 0; s != sessions; ++s)
+    {
+        for (int k = 0; k != papers_in_session; ++k)
+        {
+            int paper = -1;
+            for (int x : candidates)
+                if (slot_in_unassigned[x] >= 0 && affinity[x] > 0 && (paper < 0 || affinity[x] > affinity[paper]))
+                    paper = x;
+            if (paper < 0)
+                paper = unassigned[std::uniform_int_distribution<int>(0, unassigned.size() - 1)(rng)];
+
+            int pick = slot_in_unassigned[paper];
+            unassigned[pick] = unassigned.back();
+            slot_in_unassigned[unassigned[pick]] = pick;
+            unassigned.pop_back();
+            slot_in_unassigned[paper] = -1;
+            grouped.push_back(paper);
+
+            const int *near = distance_matrix->neighbours(paper);
+            const double *distances = distance_matrix->neighbour_distances(paper);
+            for (int e = 0; e != distance_matrix->neighbour_count(paper); ++e)
+            {
+                if (!touched[near[e]])
+                {
+                    touched[near[e]] = 1;
+                    candidates.push_back(near[e]);
+                }
+                affinity[near[e]] += D - distances[e];
+            }
+        }
+        for (int x : candidates)
+        {
+            affinity[x] = 0;
+            touched[x] = 0;
+        }
+        candidates.clear();
+    }
+
+    // Fill each time slot with the sessions least related to the ones already in it
+    vector<int> session_of(n);
+    for (int i = 0; i != n; ++i)
+        session_of[grouped[i]] = i / papers_in_session;
+    State state;
+    state.reserve(n);
+    vector<double> spread(sessions, 0.0);
+    vector<bool> placed(sessions, false);
+    for (int t = 0; t != sessions_in_track; ++t)
+    {
+        std::fill(spread.begin(), spread.end(), 0.0);
+        for (int i = 0; i != parallel_tracks; ++i)
+        {
+            int choice = -1;
+            for (int s = 0; s != sessions; ++s)
+                if (!placed[s] && (choice < 0 || (i && spread[s] < spread[choice])))
+                    choice = s;
+            placed[choice] = true;
+            for (int k = 0; k != papers_in_session; ++k)
+            {
+                int x = grouped[choice * papers_in_session + k];
+                const int *near = distance_matrix->neighbours(x);
+                const double *distances = distance_matrix->neighbour_distances(x);
+                for (int e = 0; e != distance_matrix->neighbour_count(x); ++e)
+                    spread[session_of[near[e]]] += D - distances[e];
+            }
+            state.insert(state.end(), grouped.begin() + choice * papers_in_session, grouped.begin() + (choice + 1) * papers_in_session);
+        }
+    }
+    return state;
 }
 
-State HillClimb::random_initialize()
+void HillClimb::random_initialize(State &random_state)
 {
-    State random_state(parallel_tracks * sessions_in_track * papers_in_session);
+    random_state.resize(parallel_tracks * sessions_in_track * papers_in_session);
     std::iota(random_state.begin(), random_state.end(), 0);
 
     std::shuffle(random_state.begin(), random_state.end(), rng);
-    return random_state;
 }
 
 std::pair<int, int> HillClimb::next_state()
@@ -110,114 +327,402 @@ std::pair<int, int> HillClimb::next_state()
     return std::make_pair(i, j);
 }
 
+Move HillClimb::make_move(int index_a, int index_b, const State &state) const
+{
+    int papers_in_time_slot = papers_in_session * parallel_tracks;
+    Move move;
+    move.index_a = index_a;
+    move.index_b = index_b;
+    move.paper_a = state[index_a];
+    move.paper_b = state[index_b];
+    move.session_a = index_a / papers_in_session;
+    move.session_b = index_b / papers_in_session;
+    move.slot_a = index_a / papers_in_time_slot;
+    move.slot_b = index_b / papers_in_time_slot;
+    return move;
+}
+
 void HillClimb::update_state(int index_a, int index_b, State &state)
 {
-    int a = state[index_a];
-    int b = state[index_b];
+    update_state(make_move(index_a, index_b, state), state);
+}
+
+void HillClimb::update_state(const Move &move, State &state)
+{
+    int a = move.paper_a;
+    int b = move.paper_b;
     int n = parallel_tracks * sessions_in_track * papers_in_session;
-    state[index_a] = b;
-    state[index_b] = a;
-    int session_seq_a = ((index_a + papers_in_session) / papers_in_session) - 1;
-    int session_seq_b = ((index_b + papers_in_session) / papers_in_session) - 1;
+    state[move.index_a] = b;
+    state[move.index_b] = a;
+    if (sparse)
+    {
+        position[a] = move.index_b;
+        position[b] = move.index_a;
+        occupant[move.index_a] = b;
+        occupant[move.index_b] = a;
+        return;
+    }
+    if (summed)
+    {
+        const float *features_a = distance_matrix->features(a), *features_b = distance_matrix->features(b);
+        double *session_a = session_sum(move.session_a), *session_b = session_sum(move.session_b);
+        double *slot_a = slot_sum(move.slot_a), *slot_b = slot_sum(move.slot_b);
+        for (int j = 0; j != distance_matrix->get_dimensions(); ++j)
+        {
+            double delta = static_cast<double>(features_b[j]) - features_a[j];
+            session_a[j] += delta;
+            session_b[j] -= delta;
+            if (move.slot_a != move.slot_b)
+            {
+                slot_a[j] += delta;
+                slot_b[j] -= delta;
+            }
+        }
+        return;
+    }
 
-    for (int i = 0; i != n; ++i)
+    // d is symmetric, so column a of the matrix is read as row a
+    const double *row_a = distance_matrix->row(a, row_buffer_a.data());
+    const double *row_b = distance_matrix->row(b, row_buffer_b.data());
+    kernels().swap_update(session_row(move.session_a), session_row(move.session_b), row_a, row_b, n);
+    if (move.slot_a != move.slot_b)
+        kernels().swap_update(slot_row(move.slot_a), slot_row(move.slot_b), row_a, row_b, n);
+
+    if (move.session_a == move.session_b)
+        return;
+    // Only the pairs involving either session change, a moved to b's session and b to a's
+    int sessions = parallel_tracks * sessions_in_track;
+    for (int s = 0; s != sessions; ++s)
     {
-        session_distance_matrix[i][session_seq_a] += distance_matrix[i][b] - distance_matrix[i][a];
-        session_distance_matrix[i][session_seq_b] += distance_matrix[i][a] - distance_matrix[i][b];
+        if (s == move.session_a || s == move.session_b)
+            continue;
+        double delta = session_row(s)[b] - session_row(s)[a];
+        session_pair(move.session_a, s) = session_pair(s, move.session_a) += delta;
+        session_pair(move.session_b, s) = session_pair(s, move.session_b) -= delta;
     }
+    refresh_session_pairs(move.session_a, move.session_a, move.session_b, state);
+    refresh_session_pairs(move.session_b, move.session_a, move.session_b, state);
+}
+
+SessionMove HillClimb::make_session_move(int session_a, int session_b) const
+{
+    SessionMove move;
+    move.session_a = session_a;
+    move.session_b = session_b;
+    move.slot_a = session_a / parallel_tracks;
+    move.slot_b = session_b / parallel_tracks;
+    return move;
 }
 
-double HillClimb::score_increment(int index_a, int index_b, State state) const
+SessionMove HillClimb::next_session_move()
 {
+    int sessions = parallel_tracks * sessions_in_track;
+    std::uniform_int_distribution<int> session(0, sessions - 1);
+    int a = session(rng), b;
+    do
+        b = session(rng);
+    while (b / parallel_tracks == a / parallel_tracks);
+    return make_session_move(a, b);
+}
+
+double HillClimb::score_increment(const SessionMove &move) const
+{
+    if (move.slot_a == move.slot_b)
+        return 0;
+    if (sparse)
+        return sparse_score_increment(move);
+    if (summed)
+        return summed_score_increment(move);
+
+    // Each session trades the competitors of its own slot for those of the other one
     double change = 0;
-    int a = state[index_a];
-    int b = state[index_b];
-    int session_seq_a = ((index_a + papers_in_session) / papers_in_session) - 1;
-    int session_seq_b = ((index_b + papers_in_session) / papers_in_session) - 1;
-    int papers_in_time_slot = papers_in_session * parallel_tracks;
-    int time_slot_a = ((index_a + papers_in_time_slot) / papers_in_time_slot) - 1;
-    int time_slot_b = ((index_b + papers_in_time_slot) / papers_in_time_slot) - 1;
-    if (session_seq_a == session_seq_b)
+    for (int i = 0; i != parallel_tracks; ++i)
+    {
+        int in_a = move.slot_a * parallel_tracks + i;
+        int in_b = move.slot_b * parallel_tracks + i;
+        if (in_b != move.session_b)
+            change += session_pair(move.session_a, in_b) - session_pair(move.session_b, in_b);
+        if (in_a != move.session_a)
+            change += session_pair(move.session_b, in_a) - session_pair(move.session_a, in_a);
+    }
+    return trade_of_coefficient * change;
+}
+
+void HillClimb::update_state(const SessionMove &move, State &state)
+{
+    if (move.slot_a == move.slot_b)
+        return;
+    int n = parallel_tracks * sessions_in_track * papers_in_session;
+    int sessions = parallel_tracks * sessions_in_track;
+
+    std::swap_ranges(state.begin() + move.session_a * papers_in_session, state.begin() + (move.session_a + 1) * papers_in_session,
+                     state.begin() + move.session_b * papers_in_session);
+    if (sparse)
+    {
+        std::swap_ranges(occupant.begin() + move.session_a * papers_in_session, occupant.begin() + (move.session_a + 1) * papers_in_session,
+                         occupant.begin() + move.session_b * papers_in_session);
+        for (int k = 0; k != papers_in_session; ++k)
+        {
+            position[state[move.session_a * papers_in_session + k]] = move.session_a * papers_in_session + k;
+            position[state[move.session_b * papers_in_session + k]] = move.session_b * papers_in_session + k;
+        }
+        return;
+    }
+    if (summed)
+    {
+        // Each slot trades the summed vector of its session for that of the other one
+        double *session_a = session_sum(move.session_a), *session_b = session_sum(move.session_b);
+        double *slot_a = slot_sum(move.slot_a), *slot_b = slot_sum(move.slot_b);
+        for (int j = 0; j != distance_matrix->get_dimensions(); ++j)
+        {
+            double delta = session_b[j] - session_a[j];
+            slot_a[j] += delta;
+            slot_b[j] -= delta;
+            std::swap(session_a[j], session_b[j]);
+        }
+        return;
+    }
+    kernels().swap_update(slot_row(move.slot_a), slot_row(move.slot_b), session_row(move.session_a), session_row(move.session_b), n);
+    std::swap_ranges(session_row(move.session_a), session_row(move.session_a) + n, session_row(move.session_b));
+
+    for (int s = 0; s != sessions; ++s)
+        std::swap(session_pair(move.session_a, s), session_pair(move.session_b, s));
+    for (int s = 0; s != sessions; ++s)
+        std::swap(session_pair(s, move.session_a), session_pair(s, move.session_b));
+}
+
+double HillClimb::score_increment(int index_a, int index_b, const State &state) const
+{
+    return score_increment(make_move(index_a, index_b, state));
+}
+
+double HillClimb::score_increment(const Move &move) const
+{
+    if (sparse)
+        return sparse_score_increment(move);
+    if (summed)
+        return summed_score_increment(move);
+    double change = 0;
+    int a = move.paper_a;
+    int b = move.paper_b;
+    const double *session_a = session_row(move.session_a);
+    const double *session_b = session_row(move.session_b);
+    if (move.session_a == move.session_b)
         return 0;
-    else if (time_slot_a == time_slot_b)
-        change = (trade_of_coefficient + 1) * (session_distance_matrix[a][session_seq_a] + session_distance_matrix[b][session_seq_b] - session_distance_matrix[a][session_seq_b] - session_distance_matrix[b][session_seq_a] + 2 * distance_matrix[a][b]);
+    else if (move.slot_a == move.slot_b)
+        change = (trade_of_coefficient + 1) * (session_a[a] + session_b[b] - session_b[a] - session_a[b] + 2 * (*distance_matrix)(a, b));
 
     else
     {
-        change = (trade_of_coefficient + 1) * (session_distance_matrix[a][session_seq_a] + session_distance_matrix[b][session_seq_b] - session_distance_matrix[a][session_seq_b] - session_distance_matrix[b][session_seq_a]) + 2 * distance_matrix[a][b];
+        change = (trade_of_coefficient + 1) * (session_a[a] + session_b[b] - session_b[a] - session_a[b]) + 2 * (*distance_matrix)(a, b);
 
-        for (int i = 0; i < parallel_tracks; ++i)
-            change += trade_of_coefficient * (session_distance_matrix[a][time_slot_b * parallel_tracks + i] + session_distance_matrix[b][time_slot_a * parallel_tracks + i] - session_distance_matrix[a][time_slot_a * parallel_tracks + i] - session_distance_matrix[b][time_slot_b * parallel_tracks + i]);
+        // Distances to the competing sessions of either slot come from the slot aggregate
+        const double *slot_a = slot_row(move.slot_a);
+        const double *slot_b = slot_row(move.slot_b);
+        change += trade_of_coefficient * (slot_b[a] + slot_a[b] - slot_a[a] - slot_b[b]);
     }
 
     return change;
 }
 
-double HillClimb::score(State state)
+void HillClimb::neighbour_sums(int x, const Move &move, double &session_a, double &session_b, double &slot_a, double &slot_b) const
 {
-    double score1 = 0.0;
-    for (int i = 0; i < parallel_tracks; i++)
-        for (int j = 0; j < sessions_in_track; j++)
-            for (int k = 0; k < papers_in_session; k++)
-                for (int l = k + 1; l < papers_in_session; l++)
-                {
-                    int index1 = j * (papers_in_session * parallel_tracks) + i * papers_in_session + k;
-                    int index2 = j * (papers_in_session * parallel_tracks) + i * papers_in_session + l;
-                    score1 += 1 - distance_matrix[state[index1]][state[index2]];
-                }
+    // Every paper is at the default distance D from x except x itself and its neighbours,
+    // so each sum is D times the papers it covers less the affinity D - d(x, e) of those
+    const double D = distance_matrix->get_default_distance();
+    const int papers_in_time_slot = papers_in_session * parallel_tracks;
+    double near_a = 0, near_b = 0, near_slot_a = 0, near_slot_b = 0;
+    auto add = [&](int at, double affinity) {
+        int session = at / papers_in_session, slot = at / papers_in_time_slot;
+        if (session == move.session_a)
+            near_a += affinity;
+        else if (session == move.session_b)
+            near_b += affinity;
+        if (slot == move.slot_a)
+            near_slot_a += affinity;
+        else if (slot == move.slot_b)
+            near_slot_b += affinity;
+    };
+    add(position[x], D);
+    const int *near = distance_matrix->neighbours(x);
+    const double *distances = distance_matrix->neighbour_distances(x);
+    for (int e = 0; e != distance_matrix->neighbour_count(x); ++e)
+        add(position[near[e]], D - distances[e]);
 
-    // Sum of distances for competing papers.
-    double score2 = 0.0;
-    for (int i = 0; i < parallel_tracks; i++)
-        for (int j = 0; j < sessions_in_track; j++)
-            for (int k = 0; k < papers_in_session; k++)
-                for (int l = i + 1; l < parallel_tracks; l++)
-                    for (int m = 0; m < papers_in_session; m++)
-                    {
-                        int index1 = j * (papers_in_session * parallel_tracks) + i * papers_in_session + k;
-                        int index2 = j * (papers_in_session * parallel_tracks) + l * papers_in_session + m;
-                        score2 += distance_matrix[state[index1]][state[index2]];
-                    }
-    double score = score1 + trade_of_coefficient * score2;
-    return score;
+    session_a = papers_in_session * D - near_a;
+    session_b = papers_in_session * D - near_b;
+    slot_a = papers_in_time_slot * D - near_slot_a;
+    slot_b = papers_in_time_slot * D - near_slot_b;
 }
 
-State HillClimb::hill_climb(bool random_init, double duration, const int seed = 0)
+double HillClimb::sparse_score_increment(const Move &move) const
 {
-    duration *= 60; // Assumed in minutes originally
-    auto initial_time = Time::now();
-    decltype(initial_time) now;
-    decltype(now - initial_time) dur;
-    decltype(std::chrono::duration_cast<double_seconds>(dur)) secs;
+    if (move.session_a == move.session_b)
+        return 0;
+    int a = move.paper_a;
+    int b = move.paper_b;
+    double session_a_a, session_b_a, slot_a_a, slot_b_a;
+    double session_a_b, session_b_b, slot_a_b, slot_b_b;
+    neighbour_sums(a, move, session_a_a, session_b_a, slot_a_a, slot_b_a);
+    neighbour_sums(b, move, session_a_b, session_b_b, slot_a_b, slot_b_b);
 
-    State state, best_state;
+    // The same change as score_increment with the session and slot rows read at a and b
+    double sessions = session_a_a + session_b_b - session_b_a - session_a_b;
+    if (move.slot_a == move.slot_b)
+        return (trade_of_coefficient + 1) * (sessions + 2 * (*distance_matrix)(a, b));
+    return (trade_of_coefficient + 1) * sessions + 2 * (*distance_matrix)(a, b) +
+           trade_of_coefficient * (slot_b_a + slot_a_b - slot_a_a - slot_b_b);
+}
+
+double HillClimb::sparse_score_increment(const SessionMove &move) const
+{
+    // Each session trades the competitors of its own slot for those of the other one. Both slots keep
+    // parallel_tracks - 1 competitors per session, so only the affinity D - d of the neighbours changes.
+    const double D = distance_matrix->get_default_distance();
+    const int papers_in_time_slot = papers_in_session * parallel_tracks;
+    double change = 0;
+    for (int side = 0; side != 2; ++side)
+    {
+        int own = side ? move.session_b : move.session_a, other = side ? move.session_a : move.session_b;
+        int own_slot = side ? move.slot_b : move.slot_a, other_slot = side ? move.slot_a : move.slot_b;
+        for (int k = 0; k != papers_in_session; ++k)
+        {
+            int x = occupant[own * papers_in_session + k];
+            const int *near = distance_matrix->neighbours(x);
+            const double *distances = distance_matrix->neighbour_distances(x);
+            for (int e = 0; e != distance_matrix->neighbour_count(x); ++e)
+            {
+                int at = position[near[e]];
+                int session = at / papers_in_session, slot = at / papers_in_time_slot;
+                if (slot == own_slot && session != own)
+                    change += D - distances[e];
+                else if (slot == other_slot && session != other)
+                    change -= D - distances[e];
+            }
+        }
+    }
+    return trade_of_coefficient * change;
+}
+
+double HillClimb::summed_distance(int x, const double *sum, int count, bool holds) const
+{
+    double dot = kernels().mixed_dot(distance_matrix->features(x), sum, distance_matrix->get_dimensions());
+    return holds ? count - 1 - (dot - self_dots[x]) : count - dot;
+}
+
+double HillClimb::summed_score_increment(const Move &move) const
+{
+    if (move.session_a == move.session_b)
+        return 0;
+    int a = move.paper_a;
+    int b = move.paper_b;
+    const int papers_in_time_slot = papers_in_session * parallel_tracks;
+
+    // The same change as score_increment with the session and slot rows read at a and b
+    double sessions = summed_distance(a, session_sum(move.session_a), papers_in_session, true) +
+                      summed_distance(b, session_sum(move.session_b), papers_in_session, true) -
+                      summed_distance(a, session_sum(move.session_b), papers_in_session, false) -
+                      summed_distance(b, session_sum(move.session_a), papers_in_session, false);
+    if (move.slot_a == move.slot_b)
+        return (trade_of_coefficient + 1) * (sessions + 2 * (*distance_matrix)(a, b));
+    double slots = summed_distance(a, slot_sum(move.slot_b), papers_in_time_slot, false) +
+                   summed_distance(b, slot_sum(move.slot_a), papers_in_time_slot, false) -
+                   summed_distance(a, slot_sum(move.slot_a), papers_in_time_slot, true) -
+                   summed_distance(b, slot_sum(move.slot_b), papers_in_time_slot, true);
+    return (trade_of_coefficient + 1) * sessions + 2 * (*distance_matrix)(a, b) + trade_of_coefficient * slots;
+}
+
+double HillClimb::summed_score_increment(const SessionMove &move) const
+{
+    // Between disjoint sessions a and c the distances sum to k^2 - S_a . S_c, so trading the competitors
+    // of one slot for those of the other changes the score by C (S_b - S_a) . ((T_b - S_b) - (T_a - S_a))
+    const double *session_a = session_sum(move.session_a), *session_b = session_sum(move.session_b);
+    const double *slot_a = slot_sum(move.slot_a), *slot_b = slot_sum(move.slot_b);
+    double change = 0;
+    for (int j = 0; j != distance_matrix->get_dimensions(); ++j)
+        change += (session_b[j] - session_a[j]) * ((slot_b[j] - session_b[j]) - (slot_a[j] - session_a[j]));
+    return trade_of_coefficient * change;
+}
+
+double HillClimb::score(const State &state) const
+{
+    return score_schedule(*distance_matrix, state, parallel_tracks, sessions_in_track, papers_in_session, trade_of_coefficient);
+}
+
+double HillClimb::search(bool random_init, SearchBudget &budget, State &best_state)
+{
+    State state;
     auto n = parallel_tracks * sessions_in_track * papers_in_session;
-    auto count_limit = static_cast<int>(std::pow(n, 2));
-    rng.seed(seed);
+    const long long count_limit = static_cast<long long>(n) * n; // n^2 does not fit an int beyond 46340 papers
 
-    double best_score = 0;
+    double best_score = std::numeric_limits<double>::lowest();
+    if (resume_point && !resume_point->best_state.empty())
+    {
+        best_state = resume_point->best_state;
+        best_score = resume_point->best_score;
+    }
+    bool resuming = resume_point && !resume_point->state.empty();
 
-    while (secs.count() < duration)
+    SearchTrace *trace = budget.get_trace();
+    do
     {
-        if (random_init)
-            state = random_initialize();
+        RestartEvent restart;
+        if (trace)
+        {
+            restart.start = budget.elapsed();
+            restart.moves = budget.get_iterations();
+        }
+        ++stats.restarts;
+
+        // A resumed worker first finishes the restart it was in, the aggregates are rebuilt from its state
+        long long first = 0;
+        if (resuming)
+        {
+            state = resume_point->state;
+            first = resume_point->stall;
+            resuming = false;
+        }
+        else if (random_init)
+            random_initialize(state);
         else
             state = greedy_initialize();
         construct_session_matrix(state);
 
         double accumulated_score = 0;
         double objective_function = score(state);
-        for (int cnt = 0; cnt != count_limit && secs.count() < duration; ++cnt)
+        for (long long cnt = first; cnt < count_limit && budget.next(); ++cnt)
         {
-            auto pair = next_state();
-            auto index_a = pair.first;
-            auto index_b = pair.second;
-            double score = score_increment(index_a, index_b, state);
+            if (checkpoint_writer && checkpoint_writer->wanted(checkpoint_generation))
+                save_checkpoint(state, cnt, best_state, best_score, budget);
+
+            bool whole_session = session_share(rng);
+            Move move;
+            SessionMove session_move;
+            double score;
+            if (whole_session)
+            {
+                session_move = next_session_move();
+                score = score_increment(session_move);
+            }
+            else
+            {
+                auto pair = next_state();
+                move = make_move(pair.first, pair.second, state);
+                score = score_increment(move);
+            }
+            ++stats.evaluated;
             if (score > 0)
             {
+                ++stats.uphill;
                 accumulated_score += score;
-                update_state(index_a, index_b, state);
+                if (whole_session)
+                    update_state(session_move, state);
+                else
+                    update_state(move, state);
                 cnt = 0;
+                budget.report(objective_function + accumulated_score);
+                if (budget.wants(objective_function + accumulated_score))
+                    budget.publish(objective_function + accumulated_score, state);
             }
             else
             {
@@ -226,16 +731,23 @@ State HillClimb::hill_climb(bool random_init, double duration, const int seed =
 
                 if (update)
                 {
+                    stats.accepted(score);
                     accumulated_score += score;
-                    update_state(index_a, index_b, state);
+                    if (whole_session)
+                        update_state(session_move, state);
+                    else
+                        update_state(move, state);
                 }
             }
+        }
 
-            now = Time::now();
-            dur = now - initial_time;
-            secs = std::chrono::duration_cast<double_seconds>(dur);
-
-            // std::cout << secs.count() << " " << duration << std::endl;
+        if (trace)
+        {
+            restart.duration = budget.elapsed() - restart.start;
+            restart.moves = budget.get_iterations() - restart.moves;
+            restart.initial_score = objective_function;
+            restart.final_score = objective_function + accumulated_score;
+            trace->add(restart);
         }
 
         if ((objective_function + accumulated_score) > best_score)
@@ -243,6 +755,311 @@ State HillClimb::hill_climb(bool random_init, double duration, const int seed =
             best_score = objective_function + accumulated_score;
             best_state = state;
         }
+    } while (budget.running());
+
+    return best_score;
+}
+
+void HillClimb::save_checkpoint(const State &state, long long stall, const State &best_state, double best_score,
+                                const SearchBudget &budget)
+{
+    WorkerCheckpoint snapshot;
+    snapshot.state = state;
+    snapshot.best_state = best_state;
+    snapshot.best_score = best_score;
+    snapshot.iterations = budget.get_iterations();
+    snapshot.stall = stall;
+    std::ostringstream engine;
+    engine << rng;
+    snapshot.rng = engine.str();
+    checkpoint_writer->publish(worker_id, std::move(snapshot));
+}
+
+HillClimb *HillClimb::clone() const
+{
+    return new HillClimb(*this);
+}
+
+void HillClimb::verify_score(double tracked, const State &state) const
+{
+    // Incremental updates drift by rounding only, anything larger is a bug
+    double exact = score(state);
+    if (std::fabs(tracked - exact) > 1e-6 * std::max(1.0, std::fabs(exact)))
+        std::cout << "Score drift: tracked " << tracked << ", recomputed " << exact << std::endl;
+}
+
+// Events are written while the search runs, the rest and the counters once it is done
+static std::unique_ptr<TraceWriter> open_trace(const SearchOptions &options, std::vector<SearchTrace> &traces)
+{
+    std::unique_ptr<TraceWriter> writer;
+    if (options.trace_file.empty())
+        return writer;
+    writer.reset(new TraceWriter(options.trace_file));
+    for (std::size_t w = 0; w != traces.size(); ++w)
+    {
+        traces[w].writer = writer.get();
+        traces[w].worker = w;
+    }
+    return writer;
+}
+
+static void write_trace(TraceWriter &writer, const std::string &filename, std::vector<SearchTrace> &traces)
+{
+    if (!writer.finish(traces))
+        std::cout << "Unable to write trace file " << filename << std::endl;
+}
+
+State HillClimb::hill_climb(bool random_init, double duration, const int seed, int threads, const SearchOptions &options)
+{
+    duration *= 60; // Assumed in minutes originally
+    // A resumed search only gets what is left of its budget
+    Checkpoint resumed;
+    std::swap(resumed, restored);
+    duration -= resumed.elapsed;
+    auto deadline = Time::now() + std::chrono::duration_cast<Time::duration>(double_seconds(duration));
+
+    std::atomic<bool> stop(false);
+    const bool tracing = !options.trace_file.empty();
+    std::vector<SearchTrace> traces(std::max(1, threads));
+    std::unique_ptr<TraceWriter> trace_writer = open_trace(options, traces);
+    stats = SearchStats();
+
+    std::unique_ptr<CheckpointWriter> writer;
+    if (!options.checkpoint_file.empty())
+    {
+        Checkpoint initial = resumed;
+        initial.parallel_tracks = parallel_tracks;
+        initial.sessions_in_track = sessions_in_track;
+        initial.papers_in_session = papers_in_session;
+        initial.workers.resize(std::max(1, threads));
+        writer.reset(new CheckpointWriter(options.checkpoint_file, options.checkpoint_period, initial));
+    }
+    // Seeds a worker, or restores its random engine and position when resuming
+    auto prepare = [&](HillClimb &worker, int w) {
+        worker.checkpoint_writer = writer.get();
+        worker.worker_id = w;
+        worker.checkpoint_generation = 0;
+        worker.resume_point = static_cast<size_t>(w) < resumed.workers.size() ? &resumed.workers[w] : nullptr;
+        if (worker.resume_point && !worker.resume_point->rng.empty())
+        {
+            std::istringstream engine(worker.resume_point->rng);
+            engine >> worker.rng;
+        }
     };
-    return best_state;
-}
\ No newline at end of file
+    auto run = [&](HillClimb &worker, int w, State &found) {
+        SearchBudget budget(deadline, options, &stop, tracing ? &traces[w] : nullptr);
+        if (worker.resume_point)
+            budget.resume(worker.resume_point->iterations);
+        double score = worker.search(random_init, budget, found);
+        if (writer)
+            writer->retire(w);
+        worker.checkpoint_writer = nullptr;
+        worker.resume_point = nullptr;
+        return score;
+    };
+
+    State best_state;
+    if (threads <= 1)
+    {
+        rng.seed(seed);
+        prepare(*this, 0);
+        double found = run(*this, 0, best_state);
+        if (options.verify_scores)
+            verify_score(found, best_state);
+        traces[0].stats = stats;
+        if (tracing)
+            write_trace(*trace_writer, options.trace_file, traces);
+        return best_state;
+    }
+
+    // Every worker owns a copy of the search state (rng, session_distance_matrix)
+    // while the distance matrix itself is shared read-only.
+    std::vector<std::unique_ptr<HillClimb>> workers;
+    std::vector<State> states(threads);
+    std::vector<double> scores(threads);
+    std::vector<std::thread> pool;
+
+    for (int w = 0; w != threads; ++w)
+    {
+        workers.emplace_back(clone());
+        std::seed_seq seq{seed, w};
+        workers[w]->rng.seed(seq);
+        prepare(*workers[w], w);
+        pool.emplace_back([&, w]() { scores[w] = run(*workers[w], w, states[w]); });
+    }
+    for (auto &t : pool)
+        t.join();
+
+    for (int w = 0; w != threads; ++w)
+    {
+        traces[w].stats = workers[w]->stats;
+        stats.merge(workers[w]->stats);
+        if (options.verify_scores)
+            verify_score(scores[w], states[w]);
+    }
+    if (tracing)
+        write_trace(*trace_writer, options.trace_file, traces);
+
+    // Ties go to the lowest worker id so a fixed seed and thread count pick the same winner.
+    int best = 0;
+    for (int w = 1; w != threads; ++w)
+        if (scores[w] > scores[best])
+            best = w;
+
+    return states[best];
+}
+
+State HillClimb::warm_start(State state, double duration, int max_moved, const SearchOptions &options)
+{
+    auto deadline = Time::now() + std::chrono::duration_cast<Time::duration>(double_seconds(duration * 60));
+    const bool tracing = !options.trace_file.empty();
+    std::vector<SearchTrace> traces(1);
+    std::unique_ptr<TraceWriter> trace_writer = open_trace(options, traces);
+    SearchBudget budget(deadline, options, nullptr, tracing ? &traces[0] : nullptr);
+    stats = SearchStats();
+
+    const int n = parallel_tracks * sessions_in_track * papers_in_session;
+    const int sessions = parallel_tracks * sessions_in_track;
+    const int papers_in_time_slot = papers_in_session * parallel_tracks;
+    const double MIN_GAIN = 1e-9; // smaller gains are rounding noise and could cycle
+
+    // The papers the schedule lacks go one by one to the free position where they score best
+    vector<bool> placed(n, false);
+    vector<int> holes;
+    for (int i = 0; i != n; ++i)
+    {
+        if (state[i] < 0)
+            holes.push_back(i);
+        else
+            placed[state[i]] = true;
+    }
+    vector<char> affected(sessions, holes.empty());
+    for (int i : holes)
+        affected[i / papers_in_session] = true;
+    for (int x = 0; x != n; ++x)
+    {
+        if (placed[x])
+            continue;
+        int best = -1;
+        double best_gain = std::numeric_limits<double>::lowest();
+        for (int i : holes)
+        {
+            if (state[i] >= 0)
+                continue;
+            int session = i / papers_in_session, slot = i / papers_in_time_slot;
+            double gain = 0;
+            for (int j = slot * papers_in_time_slot; j != (slot + 1) * papers_in_time_slot; ++j)
+            {
+                if (state[j] < 0)
+                    continue;
+                double d = (*distance_matrix)(x, state[j]);
+                gain += j / papers_in_session == session ? 1 - d : trade_of_coefficient * d;
+            }
+            if (gain > best_gain)
+            {
+                best_gain = gain;
+                best = i;
+            }
+        }
+        state[best] = x;
+    }
+
+    // Papers are counted as moved while they are outside the session they were placed in
+    vector<int> home(n);
+    for (int i = 0; i != n; ++i)
+        home[state[i]] = i / papers_in_session;
+    int moved = 0;
+    auto moved_by_swap = [&](const Move &move) {
+        return (home[move.paper_a] != move.session_b) + (home[move.paper_b] != move.session_a) - (home[move.paper_a] != move.session_a) -
+               (home[move.paper_b] != move.session_b);
+    };
+    auto moved_by_session_move = [&](const SessionMove &move) {
+        int change = 0;
+        for (int k = 0; k != papers_in_session; ++k)
+        {
+            int a = state[move.session_a * papers_in_session + k], b = state[move.session_b * papers_in_session + k];
+            change += (home[a] != move.session_b) - (home[a] != move.session_a) + (home[b] != move.session_a) - (home[b] != move.session_b);
+        }
+        return change;
+    };
+    auto within_cap = [&](int change) { return max_moved < 0 || moved + change <= max_moved; };
+
+    construct_session_matrix(state);
+    double current = score(state);
+    budget.report(current);
+    bool scanning = true;
+    while (scanning && budget.running())
+    {
+        // Best improvement over the moves that touch an affected session
+        double best_gain = MIN_GAIN;
+        bool found = false, whole_session = false;
+        Move best_move;
+        SessionMove best_session_move;
+        for (int s = 0; s != sessions && scanning; ++s)
+        {
+            if (!affected[s])
+                continue;
+            for (int i = s * papers_in_session; i != (s + 1) * papers_in_session && scanning; ++i)
+                for (int j = 0; j != n; ++j)
+                {
+                    if (j / papers_in_session == s)
+                        continue;
+                    if (!(scanning = budget.next()))
+                        break;
+                    ++stats.evaluated;
+                    Move move = make_move(i, j, state);
+                    double gain = score_increment(move);
+                    if (gain > best_gain && within_cap(moved_by_swap(move)))
+                    {
+                        best_gain = gain;
+                        best_move = move;
+                        found = true;
+                        whole_session = false;
+                    }
+                }
+            for (int b = 0; b != sessions && scanning; ++b)
+            {
+                if (b / parallel_tracks == s / parallel_tracks)
+                    continue;
+                if (!(scanning = budget.next()))
+                    break;
+                ++stats.evaluated;
+                SessionMove move = make_session_move(s, b);
+                double gain = score_increment(move);
+                if (gain > best_gain && within_cap(moved_by_session_move(move)))
+                {
+                    best_gain = gain;
+                    best_session_move = move;
+                    found = true;
+                    whole_session = true;
+                }
+            }
+        }
+        if (!found)
+            break;
+
+        ++stats.uphill;
+        if (whole_session)
+        {
+            moved += moved_by_session_move(best_session_move);
+            update_state(best_session_move, state);
+            std::swap(affected[best_session_move.session_a], affected[best_session_move.session_b]);
+        }
+        else
+        {
+            moved += moved_by_swap(best_move);
+            update_state(best_move, state);
+        }
+        current += best_gain;
+        budget.report(current);
+    }
+
+    stats.placed = holes.size();
+    stats.moved = moved;
+    if (options.verify_scores)
+        verify_score(current, state);
+    traces[0].stats = stats;
+    if (tracing)
+        write_trace(*trace_writer, options.trace_file, traces);
+    return state;
+}
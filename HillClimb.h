@@ -11,45 +11,168 @@
 #include <utility>
 #include <random>
 
+#include "Checkpoint.h"
+#include "DistanceMatrix.h"
+#include "SearchBudget.h"
+
 using std::vector;
 using State = vector<int>;
 
+// A swap of the papers at two positions of a state, with everything the
+// evaluation needs worked out once
+struct Move
+{
+  int index_a, index_b;     // positions in the state
+  int paper_a, paper_b;     // papers at those positions before the swap
+  int session_a, session_b; // sessions the positions belong to
+  int slot_a, slot_b;       // time slots the positions belong to
+};
+
+// An exchange of the time slots of two whole sessions. Reordering the
+// tracks of a slot never changes the score, so this is the only move
+// between sessions worth making.
+struct SessionMove
+{
+  int session_a, session_b;
+  int slot_a, slot_b;
+};
+
 class HillClimb
 {
-private:
-  double **distance_matrix;
+protected:
+  const DistanceMatrix *distance_matrix;
   int parallel_tracks;
   int sessions_in_track;
   int papers_in_session;
   double trade_of_coefficient;
 
-  vector<vector<double>> session_distance_matrix;
+  // Session major aggregates, entry [s * n + x] is the sum of d(x, e) over the papers e of session s
+  vector<double> session_distance_matrix;
+  // The same sums over all papers of time slot t, i.e. over the parallel sessions of t
+  vector<double> slot_distance_matrix;
+  // Entry [a * sessions + b] is the sum of d(x, y) over the papers x of session a and y of session b
+  vector<double> session_pair_matrix;
+
+  // Scratch rows for matrices that are not stored as plain doubles
+  vector<double> row_buffer_a, row_buffer_b;
+
+  // A sparse matrix has no dense aggregates, every sum over a session or slot is taken over the
+  // neighbours of a paper instead. position[x] is the index of paper x in the state and occupant
+  // a copy of the state, for the moves that are only given sessions.
+  bool sparse;
+  vector<int> position, occupant;
+
+  // A linear feature matrix (DistanceMatrix::is_linear) keeps the summed feature vectors of every session
+  // and time slot in place of the dense aggregates, O(n d / k) instead of O(n^2 / k). A sum of d(x, e) over
+  // a session or slot is its number of papers less x . (its summed vector), corrected for x itself with
+  // self_dots[x] = x . x.
+  bool summed;
+  vector<double> session_sums, slot_sums, self_dots;
 
   std::default_random_engine rng;
   std::uniform_int_distribution<std::default_random_engine::result_type> dist;
+  std::bernoulli_distribution session_share; // proposes a whole session move instead of a paper swap
+
+  // Counters of this worker, merged by hill_climb
+  SearchStats stats;
 
-  void construct_session_matrix(State);
+  // Search to continue in the next hill_climb, no workers for a fresh one
+  Checkpoint restored;
+  // Set on every worker while hill_climb runs
+  CheckpointWriter *checkpoint_writer = nullptr;
+  const WorkerCheckpoint *resume_point = nullptr; // where this worker continues from, null for a fresh start
+  int worker_id = 0;
+  long long checkpoint_generation = 0;
+
+  // Hands where the restart loop is to the checkpoint writer
+  void save_checkpoint(const State &state, long long stall, const State &best_state, double best_score, const SearchBudget &);
+
+  void construct_session_matrix(const State &);
 
   // Initialization Schemes
-  State random_initialize();
+  void random_initialize(State &);
   State greedy_initialize();
+  State sparse_greedy_initialize();
   std::pair<int, int> next_state();
+  SessionMove next_session_move();
+
+  double *session_row(int s) { return &session_distance_matrix[static_cast<size_t>(s) * distance_matrix->size()]; }
+  const double *session_row(int s) const { return &session_distance_matrix[static_cast<size_t>(s) * distance_matrix->size()]; }
+  double *slot_row(int t) { return &slot_distance_matrix[static_cast<size_t>(t) * distance_matrix->size()]; }
+  const double *slot_row(int t) const { return &slot_distance_matrix[static_cast<size_t>(t) * distance_matrix->size()]; }
+  double *session_sum(int s) { return &session_sums[static_cast<size_t>(s) * distance_matrix->get_dimensions()]; }
+  const double *session_sum(int s) const { return &session_sums[static_cast<size_t>(s) * distance_matrix->get_dimensions()]; }
+  double *slot_sum(int t) { return &slot_sums[static_cast<size_t>(t) * distance_matrix->get_dimensions()]; }
+  const double *slot_sum(int t) const { return &slot_sums[static_cast<size_t>(t) * distance_matrix->get_dimensions()]; }
+  double &session_pair(int a, int b) { return session_pair_matrix[static_cast<size_t>(a) * parallel_tracks * sessions_in_track + b]; }
+  double session_pair(int a, int b) const { return session_pair_matrix[static_cast<size_t>(a) * parallel_tracks * sessions_in_track + b]; }
 
-  std::vector<std::vector<int>> state_to_sessions(State);
-  double score(State);
+  // Recomputes the session_pair entries of session s against sessions a and b
+  void refresh_session_pairs(int s, int a, int b, const State &);
+
+  // Sparse matrices: the sums of d(x, e) over the papers e of both sessions and both slots of the move, O(neighbours of x)
+  void neighbour_sums(int x, const Move &, double &session_a, double &session_b, double &slot_a, double &slot_b) const;
+  double sparse_score_increment(const Move &) const;
+  double sparse_score_increment(const SessionMove &) const;
+
+  // Linear feature matrices: the sum of d(x, e) over the count papers e with the given summed vector,
+  // which holds x itself or not, O(d)
+  double summed_distance(int x, const double *sum, int count, bool holds) const;
+  double summed_score_increment(const Move &) const;
+  double summed_score_increment(const SessionMove &) const;
+  double score(const State &) const;
+
+  // Reports a tracked score that does not match the state's score computed from scratch
+  void verify_score(double tracked, const State &) const;
+
+  // Restart loop of a single worker, returns the best score found within the budget
+  virtual double search(bool, SearchBudget &, State &);
+
+  // Copy of this engine for another worker
+  virtual HillClimb *clone() const;
 
 public:
   // Constructors
-  HillClimb(double **, int, int, int, int);
+  HillClimb(const DistanceMatrix &, int, int, int, double);
+  virtual ~HillClimb() {}
+
+  // Counters of the last hill_climb or warm_start, merged over its workers
+  const SearchStats &get_stats() const { return stats; }
+
+  // Makes the next hill_climb continue a checkpointed search of the same shape and thread count
+  void resume(const Checkpoint &checkpoint) { restored = checkpoint; }
 
-  // Main hill climb algorithm
-  State hill_climb(bool, double, const int);
+  // Main hill climb algorithm, restarts are spread over the given number of threads
+  State hill_climb(bool, double, const int seed = 0, int threads = 1, const SearchOptions &options = SearchOptions());
+
+  // Re-optimizes an existing schedule after papers were withdrawn or added. Positions holding -1 are
+  // filled with the papers the schedule lacks, then the best swap or session move involving a session
+  // with such a position is made until none improves; without any the whole schedule is polished.
+  // At most max_moved papers end up outside their session of the filled schedule, negative for no limit.
+  State warm_start(State, double, int max_moved = -1, const SearchOptions &options = SearchOptions());
+
+  // Describes the swap of two positions of the state
+  Move make_move(int, int, const State &) const;
 
   // Increment in score when going from state 1 to state 2 by single swap
-  double score_increment(int, int, State) const;
+  double score_increment(const Move &) const;
+  double score_increment(int, int, const State &) const;
 
   //Update state and session distance matrix after single swap
+  void update_state(const Move &, State &);
   void update_state(int, int, State &);
+
+  // Describes the exchange of the time slots of two sessions
+  SessionMove make_session_move(int, int) const;
+
+  // Increment in score when exchanging the time slots of two sessions, O(parallel tracks)
+  double score_increment(const SessionMove &) const;
+
+  //Update state and aggregates after exchanging the time slots of two sessions
+  void update_state(const SessionMove &, State &);
+
+  // Share of proposed moves that exchange whole sessions
+  static constexpr double SESSION_MOVE_SHARE = 0.1;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,210 @@
+/* 
+ * File:   Kernels.cpp
+ * Author: Varun Srivastava
+ *
+ */
+
+#include <immintrin.h>
+
+#include "Kernels.h"
+
+static void swap_update_scalar(double *x, double *y, const double *a, const double *b, int n)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        double delta = b[i] - a[i];
+        x[i] += delta;
+        y[i] -= delta;
+    }
+}
+
+static void accumulate_scalar(double *x, const double *a, int n)
+{
+    for (int i = 0; i < n; ++i)
+        x[i] += a[i];
+}
+
+static void gather_scalar(double *x, const double *row, const int *index, int n)
+{
+    for (int i = 0; i < n; ++i)
+        x[i] = row[index[i]];
+}
+
+static double sum_scalar(const double *a, int n)
+{
+    double total = 0;
+    for (int i = 0; i < n; ++i)
+        total += a[i];
+    return total;
+}
+
+static void dots_scalar(double *x, const float *a, const float *rows, std::size_t stride, int count, int d)
+{
+    for (int j = 0; j < count; ++j, rows += stride)
+    {
+        double total = 0;
+        for (int i = 0; i < d; ++i)
+            total += static_cast<double>(a[i]) * rows[i];
+        x[j] = total;
+    }
+}
+
+static double mixed_dot_scalar(const float *a, const double *b, int d)
+{
+    double total = 0;
+    for (int i = 0; i < d; ++i)
+        total += a[i] * b[i];
+    return total;
+}
+
+__attribute__((target("avx2"))) static void swap_update_avx2(double *x, double *y, const double *a, const double *b, int n)
+{
+    int i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256d delta = _mm256_sub_pd(_mm256_loadu_pd(b + i), _mm256_loadu_pd(a + i));
+        _mm256_storeu_pd(x + i, _mm256_add_pd(_mm256_loadu_pd(x + i), delta));
+        _mm256_storeu_pd(y + i, _mm256_sub_pd(_mm256_loadu_pd(y + i), delta));
+    }
+    swap_update_scalar(x + i, y + i, a + i, b + i, n - i);
+}
+
+__attribute__((target("avx2"))) static void accumulate_avx2(double *x, const double *a, int n)
+{
+    int i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm256_storeu_pd(x + i, _mm256_add_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(a + i)));
+    accumulate_scalar(x + i, a + i, n - i);
+}
+
+__attribute__((target("avx2"))) static void gather_avx2(double *x, const double *row, const int *index, int n)
+{
+    // The masked forms with an explicit source avoid spurious uninitialized warnings of the plain ones
+    const __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+    int i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm256_storeu_pd(x + i, _mm256_mask_i32gather_pd(_mm256_setzero_pd(), row, _mm_loadu_si128(reinterpret_cast<const __m128i *>(index + i)), all, 8));
+    gather_scalar(x + i, row, index + i, n - i);
+}
+
+__attribute__((target("avx2"))) static double sum_avx2(const double *a, int n)
+{
+    __m256d total = _mm256_setzero_pd();
+    int i = 0;
+    for (; i + 4 <= n; i += 4)
+        total = _mm256_add_pd(total, _mm256_loadu_pd(a + i));
+    double lanes[4];
+    _mm256_storeu_pd(lanes, total);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + sum_scalar(a + i, n - i);
+}
+
+__attribute__((target("avx2"))) static void dots_avx2(double *x, const float *a, const float *rows, std::size_t stride, int count, int d)
+{
+    for (int j = 0; j < count; ++j, rows += stride)
+    {
+        __m256d total = _mm256_setzero_pd();
+        int i = 0;
+        for (; i + 4 <= d; i += 4)
+            total = _mm256_add_pd(total, _mm256_mul_pd(_mm256_cvtps_pd(_mm_loadu_ps(a + i)), _mm256_cvtps_pd(_mm_loadu_ps(rows + i))));
+        double lanes[4];
+        _mm256_storeu_pd(lanes, total);
+        double tail = 0;
+        dots_scalar(&tail, a + i, rows + i, 0, 1, d - i);
+        x[j] = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + tail;
+    }
+}
+
+__attribute__((target("avx2"))) static double mixed_dot_avx2(const float *a, const double *b, int d)
+{
+    __m256d total = _mm256_setzero_pd();
+    int i = 0;
+    for (; i + 4 <= d; i += 4)
+        total = _mm256_add_pd(total, _mm256_mul_pd(_mm256_cvtps_pd(_mm_loadu_ps(a + i)), _mm256_loadu_pd(b + i)));
+    double lanes[4];
+    _mm256_storeu_pd(lanes, total);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + mixed_dot_scalar(a + i, b + i, d - i);
+}
+
+__attribute__((target("avx512f"))) static void swap_update_avx512(double *x, double *y, const double *a, const double *b, int n)
+{
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m512d delta = _mm512_sub_pd(_mm512_loadu_pd(b + i), _mm512_loadu_pd(a + i));
+        _mm512_storeu_pd(x + i, _mm512_add_pd(_mm512_loadu_pd(x + i), delta));
+        _mm512_storeu_pd(y + i, _mm512_sub_pd(_mm512_loadu_pd(y + i), delta));
+    }
+    swap_update_scalar(x + i, y + i, a + i, b + i, n - i);
+}
+
+__attribute__((target("avx512f"))) static void accumulate_avx512(double *x, const double *a, int n)
+{
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm512_storeu_pd(x + i, _mm512_add_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(a + i)));
+    accumulate_scalar(x + i, a + i, n - i);
+}
+
+__attribute__((target("avx512f"))) static void gather_avx512(double *x, const double *row, const int *index, int n)
+{
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm512_storeu_pd(x + i, _mm512_mask_i32gather_pd(_mm512_setzero_pd(), 0xff, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(index + i)), row, 8));
+    gather_scalar(x + i, row, index + i, n - i);
+}
+
+__attribute__((target("avx512f"))) static double sum_avx512(const double *a, int n)
+{
+    __m512d total = _mm512_setzero_pd();
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+        total = _mm512_add_pd(total, _mm512_loadu_pd(a + i));
+    double lanes[8];
+    _mm512_storeu_pd(lanes, total);
+    return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7])) + sum_scalar(a + i, n - i);
+}
+
+__attribute__((target("avx512f"))) static void dots_avx512(double *x, const float *a, const float *rows, std::size_t stride, int count, int d)
+{
+    for (int j = 0; j < count; ++j, rows += stride)
+    {
+        // Products of floats are exact in double, only the sums round
+        __m512d total = _mm512_setzero_pd();
+        int i = 0;
+        for (; i + 8 <= d; i += 8)
+            total = _mm512_fmadd_pd(_mm512_mask_cvtps_pd(_mm512_setzero_pd(), 0xff, _mm256_loadu_ps(a + i)),
+                                    _mm512_mask_cvtps_pd(_mm512_setzero_pd(), 0xff, _mm256_loadu_ps(rows + i)), total);
+        double lanes[8];
+        _mm512_storeu_pd(lanes, total);
+        double tail = 0;
+        dots_scalar(&tail, a + i, rows + i, 0, 1, d - i);
+        x[j] = ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7])) + tail;
+    }
+}
+
+__attribute__((target("avx512f"))) static double mixed_dot_avx512(const float *a, const double *b, int d)
+{
+    __m512d total = _mm512_setzero_pd();
+    int i = 0;
+    for (; i + 8 <= d; i += 8)
+        total = _mm512_fmadd_pd(_mm512_mask_cvtps_pd(_mm512_setzero_pd(), 0xff, _mm256_loadu_ps(a + i)), _mm512_loadu_pd(b + i), total);
+    double lanes[8];
+    _mm512_storeu_pd(lanes, total);
+    return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7])) + mixed_dot_scalar(a + i, b + i, d - i);
+}
+
+static Kernels select_kernels()
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return Kernels{swap_update_avx512, accumulate_avx512, gather_avx512, sum_avx512, dots_avx512, mixed_dot_avx512, "avx512"};
+    if (__builtin_cpu_supports("avx2"))
+        return Kernels{swap_update_avx2, accumulate_avx2, gather_avx2, sum_avx2, dots_avx2, mixed_dot_avx2, "avx2"};
+    return Kernels{swap_update_scalar, accumulate_scalar, gather_scalar, sum_scalar, dots_scalar, mixed_dot_scalar, "scalar"};
+}
+
+const Kernels &kernels()
+{
+    static const Kernels selected = select_kernels();
+    return selected;
+}
@@ -0,0 +1,42 @@
+/* 
+ * File:   Kernels.h
+ * Author: Varun Srivastava
+ *
+ */
+
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <cstddef>
+
+/**
+ * Vector kernels for the row updates of the search and for scoring, picked once at runtime
+ * for the widest instruction set the CPU supports (AVX-512, AVX2 or scalar).
+ */
+struct Kernels
+{
+  // x[i] += b[i] - a[i] and y[i] += a[i] - b[i] for i < n
+  void (*swap_update)(double *x, double *y, const double *a, const double *b, int n);
+
+  // x[i] += a[i] for i < n
+  void (*accumulate)(double *x, const double *a, int n);
+
+  // x[i] = row[index[i]] for i < n
+  void (*gather)(double *x, const double *row, const int *index, int n);
+
+  // Sum of a[i] for i < n
+  double (*sum)(const double *a, int n);
+
+  // x[j] = dot product of a and rows + j * stride over d floats, for j < count, summed in double
+  void (*dots)(double *x, const float *a, const float *rows, std::size_t stride, int count, int d);
+
+  // Dot product of the floats a and the doubles b over d elements
+  double (*mixed_dot)(const float *a, const double *b, int d);
+
+  // Name of the instruction set in use
+  const char *isa;
+};
+
+const Kernels &kernels();
+
+#endif /* KERNELS_H */
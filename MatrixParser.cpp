@@ -0,0 +1,186 @@
+/* 
+ * File:   MatrixParser.cpp
+ * Author: Varun Srivastava
+ *
+ */
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "MatrixParser.h"
+
+MappedFile::MappedFile() : data(nullptr), length(0)
+{
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+void MappedFile::close()
+{
+    if (data)
+        munmap(const_cast<char *>(data), length);
+    data = nullptr;
+    length = 0;
+}
+
+bool MappedFile::open(const std::string &filename)
+{
+    close();
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    length = info.st_size;
+    if (length)
+    {
+        void *mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED)
+        {
+            ::close(fd);
+            length = 0;
+            return false;
+        }
+        madvise(mapping, length, MADV_SEQUENTIAL);
+        data = static_cast<const char *>(mapping);
+    }
+    ::close(fd);
+    return true;
+}
+
+std::vector<const char *> index_lines(const char *begin, const char *end)
+{
+    std::vector<const char *> lines;
+    const char *p = begin;
+    while (p != end)
+    {
+        lines.push_back(p);
+        const char *newline = static_cast<const char *>(std::memchr(p, '\n', end - p));
+        p = newline ? newline + 1 : end;
+    }
+    lines.push_back(end);
+    return lines;
+}
+
+static inline bool is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+bool parse_double(const char *&p, const char *end, double &value)
+{
+    // Exact powers of ten, any product or quotient with them is correctly rounded
+    static const double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+    const char *start = p;
+    const char *q = p;
+    bool negative = false;
+    if (q != end && (*q == '-' || *q == '+'))
+        negative = *q++ == '-';
+
+    std::uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool any = false;
+    for (; q != end && is_digit(*q); ++q, any = true)
+        if (digits < 19)
+            mantissa = mantissa * 10 + (*q - '0'), digits += mantissa != 0;
+        else
+            ++exponent;
+    if (q != end && *q == '.')
+        for (++q; q != end && is_digit(*q); ++q, any = true)
+            if (digits < 19)
+                mantissa = mantissa * 10 + (*q - '0'), digits += mantissa != 0, --exponent;
+    if (!any)
+        return false;
+
+    if (q != end && (*q == 'e' || *q == 'E'))
+    {
+        const char *r = q + 1;
+        bool negative_exponent = false;
+        if (r != end && (*r == '-' || *r == '+'))
+            negative_exponent = *r++ == '-';
+        if (r != end && is_digit(*r))
+        {
+            int e = 0;
+            for (; r != end && is_digit(*r); ++r)
+                e = e < 10000 ? e * 10 + (*r - '0') : e;
+            exponent += negative_exponent ? -e : e;
+            q = r;
+        }
+    }
+    p = q;
+
+    if (digits < 19 && exponent >= -22 && exponent <= 22 && mantissa < (std::uint64_t(1) << 53))
+    {
+        value = static_cast<double>(mantissa);
+        value = exponent < 0 ? value / powers[-exponent] : value * powers[exponent];
+    }
+    else
+    {
+        // Rare long or extreme literals take the slow but exact route
+        std::string token(start, p);
+        value = std::strtod(token.c_str(), nullptr);
+        return true;
+    }
+    if (negative)
+        value = -value;
+    return true;
+}
+
+static inline bool is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+bool parse_row(const char *begin, const char *end, double *row, int n)
+{
+    const char *p = begin;
+    int count = 0;
+    while (true)
+    {
+        while (p != end && is_space(*p))
+            ++p;
+        if (p == end)
+            break;
+        if (count == n || !parse_double(p, end, row[count]))
+            return false;
+        if (p != end && !is_space(*p))
+            return false;
+        ++count;
+    }
+    return count == n;
+}
+
+bool parse_numbers(const char *begin, const char *end, std::vector<double> &values)
+{
+    values.clear();
+    const char *p = begin;
+    while (true)
+    {
+        while (p != end && is_space(*p))
+            ++p;
+        if (p == end)
+            return true;
+        double value;
+        if (!parse_double(p, end, value) || (p != end && !is_space(*p)))
+            return false;
+        values.push_back(value);
+    }
+}
@@ -0,0 +1,53 @@
+/* 
+ * File:   MatrixParser.h
+ * Author: Varun Srivastava
+ *
+ */
+
+#ifndef MATRIXPARSER_H
+#define MATRIXPARSER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * Read only memory mapping of a whole file.
+ */
+class MappedFile
+{
+private:
+  const char *data;
+  std::size_t length;
+
+public:
+  MappedFile();
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  // Maps the file, returns false if it cannot be opened
+  bool open(const std::string &filename);
+
+  // Drops the mapping
+  void close();
+
+  const char *begin() const { return data; }
+  const char *end() const { return data + length; }
+  std::size_t size() const { return length; }
+};
+
+// Start of every line in [begin, end), split the way getline would, followed by end itself
+std::vector<const char *> index_lines(const char *begin, const char *end);
+
+// Parses one decimal number at p, advancing p past it. Returns false if p does not start a number.
+bool parse_double(const char *&p, const char *end, double &value);
+
+// Parses exactly n whitespace separated numbers from a line, returns false if the line is malformed
+bool parse_row(const char *begin, const char *end, double *row, int n);
+
+// Parses all whitespace separated numbers of a line into values, returns false if the line is malformed
+bool parse_numbers(const char *begin, const char *end, std::vector<double> &values);
+
+#endif /* MATRIXPARSER_H */
@@ -0,0 +1,295 @@
+/* 
+ * File:   MemeticSearch.cpp
+ * Author: Varun Srivastava
+ *
+ */
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <numeric>
+
+#include "MemeticSearch.h"
+#include "WorkerPool.h"
+
+MemeticSearch::MemeticSearch(const DistanceMatrix &matrix, int p, int t, int k, double c, int islands, int threads)
+    : HillClimb(matrix, p, t, k, c), islands(std::max(1, islands)), threads(std::max(1, threads)), moves(0)
+{
+}
+
+HillClimb *MemeticSearch::clone() const
+{
+    return new MemeticSearch(*this);
+}
+
+double MemeticSearch::descend(State &state, SearchBudget &budget)
+{
+    construct_session_matrix(state);
+    double current = score(state);
+    const long long stall = static_cast<long long>(STALL_FACTOR) * state.size();
+    long long failed = 0;
+    while (failed != stall && budget.next())
+    {
+        ++moves;
+        bool whole_session = session_share(rng);
+        Move move;
+        SessionMove session_move;
+        double delta;
+        if (whole_session)
+        {
+            session_move = next_session_move();
+            delta = score_increment(session_move);
+        }
+        else
+        {
+            auto pair = next_state();
+            move = make_move(pair.first, pair.second, state);
+            delta = move.session_a == move.session_b ? 0 : score_increment(move);
+        }
+        ++stats.evaluated;
+        if (delta <= 0)
+        {
+            ++failed;
+            continue;
+        }
+        ++stats.uphill;
+        if (whole_session)
+            update_state(session_move, state);
+        else
+            update_state(move, state);
+        current += delta;
+        failed = 0;
+    }
+    return current;
+}
+
+State MemeticSearch::crossover(const State &first, const State &second)
+{
+    const int n = first.size();
+    const int sessions = parallel_tracks * sessions_in_track;
+    const State *parents[] = {&first, &second};
+
+    // Cohesion of every session of both parents, the sum of its internal distances
+    vector<std::pair<double, int>> candidates; // (cohesion, parent * sessions + session)
+    candidates.reserve(2 * sessions);
+    for (int parent = 0; parent != 2; ++parent)
+        for (int s = 0; s != sessions; ++s)
+        {
+            const int *papers = &(*parents[parent])[s * papers_in_session];
+            double internal = 0;
+            for (int i = 0; i != papers_in_session; ++i)
+                for (int j = i + 1; j != papers_in_session; ++j)
+                    internal += (*distance_matrix)(papers[i], papers[j]);
+            candidates.emplace_back(internal, parent * sessions + s);
+        }
+    std::shuffle(candidates.begin(), candidates.end(), rng); // breaks ties between the parents at random
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const std::pair<double, int> &a, const std::pair<double, int> &b) { return a.first < b.first; });
+
+    // Keep the most cohesive sessions that do not share a paper, at their parent's place if it is still free
+    State child(n, -1);
+    vector<bool> used(n, false), filled(sessions, false);
+    vector<int> displaced; // kept sessions whose place was taken
+    for (auto &candidate : candidates)
+    {
+        const int *papers = &(*parents[candidate.second / sessions])[(candidate.second % sessions) * papers_in_session];
+        if (std::any_of(papers, papers + papers_in_session, [&](int x) { return used[x]; }))
+            continue;
+        for (int i = 0; i != papers_in_session; ++i)
+            used[papers[i]] = true;
+        int s = candidate.second % sessions;
+        if (filled[s])
+        {
+            displaced.push_back(candidate.second);
+            continue;
+        }
+        filled[s] = true;
+        std::copy(papers, papers + papers_in_session, child.begin() + s * papers_in_session);
+    }
+    int free_session = 0;
+    for (int kept : displaced)
+    {
+        while (filled[free_session])
+            ++free_session;
+        filled[free_session] = true;
+        const int *papers = &(*parents[kept / sessions])[(kept % sessions) * papers_in_session];
+        std::copy(papers, papers + papers_in_session, child.begin() + free_session * papers_in_session);
+    }
+
+    // Repair: cluster the left over papers into the empty sessions, each grown
+    // from a random seed by adding the paper closest to it
+    vector<int> left;
+    for (int x = 0; x != n; ++x)
+        if (!used[x])
+            left.push_back(x);
+    vector<double> affinity(left.size());
+    for (int s = 0; s != sessions; ++s)
+    {
+        if (filled[s])
+            continue;
+        std::fill(affinity.begin(), affinity.begin() + left.size(), 0.0);
+        int pick = std::uniform_int_distribution<int>(0, left.size() - 1)(rng);
+        for (int k = 0; k != papers_in_session; ++k)
+        {
+            if (k)
+            {
+                pick = 0;
+                for (size_t i = 1; i != left.size(); ++i)
+                    if (affinity[i] < affinity[pick])
+                        pick = i;
+            }
+            int paper = left[pick];
+            child[s * papers_in_session + k] = paper;
+            left[pick] = left.back();
+            affinity[pick] = affinity[left.size() - 1];
+            left.pop_back();
+            for (size_t i = 0; i != left.size(); ++i)
+                affinity[i] += (*distance_matrix)(paper, left[i]);
+        }
+    }
+    return child;
+}
+
+int MemeticSearch::select(const vector<Member> &population)
+{
+    std::uniform_int_distribution<int> member(0, population.size() - 1);
+    int a = member(rng), b = member(rng);
+    return population[a].score >= population[b].score ? a : b;
+}
+
+bool MemeticSearch::admit(vector<Member> &population, Member &candidate)
+{
+    auto worst = std::min_element(population.begin(), population.end(),
+                                  [](const Member &a, const Member &b) { return a.score < b.score; });
+    if (candidate.score <= worst->score)
+        return false;
+    for (auto &member : population)
+        if (member.score == candidate.score)
+            return false; // most likely the same schedule, keep the population diverse
+    std::swap(*worst, candidate);
+    return true;
+}
+
+void MemeticSearch::breed(vector<Member> &population, SearchBudget &budget)
+{
+    int a = select(population), b = select(population);
+    if (a == b)
+        b = (a + 1) % population.size();
+    Member child;
+    child.state = crossover(population[a].state, population[b].state);
+    child.score = descend(child.state, budget);
+    admit(population, child);
+}
+
+double MemeticSearch::search(bool random_init, SearchBudget &budget, State &best_state)
+{
+    // Every island is an engine of its own, seeded from this one
+    std::vector<std::unique_ptr<MemeticSearch>> engines;
+    std::vector<vector<Member>> populations(islands);
+    for (int i = 0; i != islands; ++i)
+    {
+        engines.emplace_back(new MemeticSearch(*this));
+        std::seed_seq seq{static_cast<unsigned>(rng()), static_cast<unsigned>(i)};
+        engines[i]->rng.seed(seq);
+    }
+
+    // Islands split what is left of the iteration limit, and never stop the other workers on their own
+    std::vector<std::unique_ptr<SearchBudget>> budgets;
+    SearchOptions share = budget.get_options();
+    share.has_target = false;
+    share.on_improvement = ImprovementListener();
+    for (int i = 0; i != islands; ++i)
+    {
+        SearchOptions island = share;
+        if (share.max_iterations > 0)
+        {
+            long long left = std::max(0LL, share.max_iterations - budget.get_iterations());
+            island.max_iterations = left / islands + (i < left % islands);
+            // An island without a share makes no move at all, a limit of 0 would mean none
+            if (island.max_iterations == 0)
+                island.fixed_iterations = true;
+        }
+        budgets.emplace_back(new SearchBudget(budget.get_deadline(), island));
+    }
+
+    WorkerPool pool(std::min(threads, islands));
+    const int workers = pool.size();
+    auto best_of = [](const vector<Member> &population) {
+        return std::max_element(population.begin(), population.end(),
+                                [](const Member &a, const Member &b) { return a.score < b.score; }) -
+               population.begin();
+    };
+    auto best_score = [&]() {
+        double best = std::numeric_limits<double>::lowest();
+        for (auto &population : populations)
+            best = std::max(best, population[best_of(population)].score);
+        return best;
+    };
+    auto collect = [&]() {
+        long long total = 0;
+        for (auto &engine : engines)
+        {
+            total += engine->moves;
+            engine->moves = 0;
+        }
+        return total;
+    };
+
+    // Initial populations of local optima, one island per worker at a time
+    pool.run([&](int w) {
+        for (int i = w; i < islands; i += workers)
+        {
+            MemeticSearch &engine = *engines[i];
+            // At least one member, so every island has a best schedule
+            for (int m = 0; m != POPULATION && (m == 0 || budgets[i]->running()); ++m)
+            {
+                Member member;
+                if (random_init)
+                    engine.random_initialize(member.state);
+                else
+                    member.state = engine.greedy_initialize();
+                member.score = engine.descend(member.state, *budgets[i]);
+                populations[i].push_back(std::move(member));
+            }
+        }
+    });
+    budget.report(best_score());
+
+    // Islands read the clock, a round without moves would not advance this budget to its next read
+    auto islands_running = [&]() {
+        for (auto &island : budgets)
+            if (island->running())
+                return true;
+        return false;
+    };
+    while (budget.next(collect()) && islands_running())
+    {
+        pool.run([&](int w) {
+            for (int i = w; i < islands; i += workers)
+                for (int o = 0; o != OFFSPRING_PER_ROUND && budgets[i]->running(); ++o)
+                    engines[i]->breed(populations[i], *budgets[i]);
+        });
+        budget.report(best_score());
+
+        // Ring migration: a copy of each island's best goes to the next island
+        if (islands > 1)
+        {
+            vector<Member> elites;
+            for (auto &population : populations)
+                elites.push_back(population[best_of(population)]);
+            for (int i = 0; i != islands; ++i)
+                admit(populations[(i + 1) % islands], elites[i]);
+        }
+    }
+
+    for (auto &engine : engines)
+        stats.merge(engine->stats);
+
+    int best = 0;
+    for (int i = 1; i != islands; ++i)
+        if (populations[i][best_of(populations[i])].score > populations[best][best_of(populations[best])].score)
+            best = i;
+    const Member &winner = populations[best][best_of(populations[best])];
+    best_state = winner.state;
+    return winner.score;
+}
@@ -0,0 +1,66 @@
+/* 
+ * File:   MemeticSearch.h
+ * Author: Varun Srivastava
+ *
+ */
+
+#ifndef MEMETICSEARCH_H
+#define MEMETICSEARCH_H
+
+#include "HillClimb.h"
+
+/**
+ * Memetic search on an island model. Every island keeps a small population
+ * of locally optimal schedules and breeds offspring by session crossover:
+ * the most cohesive sessions of two parents are kept as long as they do
+ * not overlap and the left over papers are clustered into the remaining
+ * sessions. Offspring are improved by a descent over the same moves and
+ * incremental evaluation as HillClimb and replace the worst member if they
+ * are better and new. Islands breed a batch of offspring per round, spread
+ * over a pool of threads; between rounds the elite of every island
+ * migrates to the next one on a ring. Every island charges its moves to a
+ * budget of its own with an equal share of the iteration limit, so the
+ * descents stop in time without sharing a budget between threads.
+ */
+class MemeticSearch : public HillClimb
+{
+private:
+  struct Member
+  {
+    State state;
+    double score;
+  };
+
+  int islands;
+  int threads;
+  long long moves; // moves made by descend since the last read
+
+  // Improves a schedule until STALL_FACTOR * n moves in a row fail to or the budget runs out, returns its score
+  double descend(State &, SearchBudget &);
+
+  // Offspring of two parents, a valid schedule
+  State crossover(const State &, const State &);
+
+  // Tournament of two, index of the winner
+  int select(const vector<Member> &);
+
+  // Breeds one offspring into the population
+  void breed(vector<Member> &, SearchBudget &);
+
+  // Replaces the worst member unless the schedule is worse or already present, true if it was added
+  static bool admit(vector<Member> &, Member &);
+
+protected:
+  double search(bool, SearchBudget &, State &) override;
+  HillClimb *clone() const override;
+
+public:
+  static const int DEFAULT_ISLANDS = 2;
+  static const int POPULATION = 4;          // schedules per island
+  static const int OFFSPRING_PER_ROUND = 2; // offspring each island breeds between two migrations
+  static const int STALL_FACTOR = 20;
+
+  MemeticSearch(const DistanceMatrix &, int, int, int, double, int islands, int threads);
+};
+
+#endif /* MEMETICSEARCH_H */
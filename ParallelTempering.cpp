@@ -0,0 +1,102 @@
+/* 
+ * File:   ParallelTempering.cpp
+ * Author: Varun Srivastava
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+#include "ParallelTempering.h"
+#include "WorkerPool.h"
+
+constexpr double ParallelTempering::HOTTEST_SCALE;
+constexpr double ParallelTempering::LADDER_RATIO;
+
+ParallelTempering::ParallelTempering(const DistanceMatrix &matrix, int p, int t, int k, double c, int replicas, int threads)
+    : SimulatedAnnealing(matrix, p, t, k, c, COOLING_GEOMETRIC), replicas(std::max(2, replicas)), threads(std::max(1, threads))
+{
+}
+
+HillClimb *ParallelTempering::clone() const
+{
+    return new ParallelTempering(*this);
+}
+
+double ParallelTempering::search(bool random_init, SearchBudget &budget, State &best_state)
+{
+    // Every replica is an engine of its own, seeded from this one
+    std::vector<std::unique_ptr<ParallelTempering>> engines;
+    std::vector<Walker> walkers(replicas);
+    for (int r = 0; r != replicas; ++r)
+    {
+        engines.emplace_back(new ParallelTempering(*this));
+        std::seed_seq seq{static_cast<unsigned>(rng()), static_cast<unsigned>(r)};
+        engines[r]->rng.seed(seq);
+        engines[r]->start(walkers[r], random_init);
+    }
+
+    // Geometric ladder below the calibrated annealing start, level[r] is the
+    // rung replica r is at and replica_at is its inverse
+    const double hottest = HOTTEST_SCALE * engines[0]->calibrate_temperature(walkers[0].state);
+    std::vector<double> ladder(replicas);
+    std::vector<int> level(replicas), replica_at(replicas);
+    for (int l = 0; l != replicas; ++l)
+    {
+        ladder[l] = hottest * std::pow(LADDER_RATIO, static_cast<double>(l) / (replicas - 1));
+        level[l] = replica_at[l] = l;
+    }
+
+    int best = 0;
+    for (int r = 1; r != replicas; ++r)
+        if (walkers[r].best_score > walkers[best].best_score)
+            best = r;
+    budget.report(walkers[best].best_score);
+
+    WorkerPool pool(std::min(threads, replicas));
+    const int workers = pool.size();
+    long long moves = 0; // of the round, spread evenly over the replicas
+    auto round = [&](int w) {
+        for (int r = w; r < replicas; r += workers)
+        {
+            double temperature = ladder[level[r]];
+            for (long long i = 0, own = moves / replicas + (r < moves % replicas); i != own; ++i)
+                engines[r]->step(walkers[r], temperature);
+        }
+    };
+
+    // A round is charged once it ran, the last one is cut to the moves the iteration limit leaves
+    const long long limit = budget.get_options().max_iterations;
+    for (long long exchange = 0; budget.next(moves); ++exchange)
+    {
+        moves = static_cast<long long>(replicas) * EXCHANGE_INTERVAL;
+        if (limit > 0)
+            moves = std::min(moves, limit - budget.get_iterations());
+        pool.run(round);
+
+        for (int r = 0; r != replicas; ++r)
+            if (walkers[r].best_score > walkers[best].best_score)
+                best = r;
+        budget.report(walkers[best].best_score);
+
+        // Rungs l and l + 1 exchange with probability min(1, exp((s_hot - s_cold) * (1 / T_cold - 1 / T_hot))),
+        // alternating between even and odd pairs so a configuration can travel the whole ladder
+        for (int l = exchange % 2; l + 1 < replicas; l += 2)
+        {
+            int hot = replica_at[l], cold = replica_at[l + 1];
+            double exponent = (walkers[hot].current - walkers[cold].current) * (1 / ladder[l + 1] - 1 / ladder[l]);
+            if (exponent < 0 && (exponent < -EXP_CUTOFF || unit(rng) >= std::exp(exponent)))
+                continue;
+            std::swap(replica_at[l], replica_at[l + 1]);
+            level[hot] = l + 1;
+            level[cold] = l;
+        }
+    }
+
+    for (auto &engine : engines)
+        stats.merge(engine->stats);
+    engines[best]->finish(walkers[best]);
+    best_state = walkers[best].best_state;
+    return walkers[best].best_score;
+}
@@ -0,0 +1,42 @@
+/* 
+ * File:   ParallelTempering.h
+ * Author: Varun Srivastava
+ *
+ */
+
+#ifndef PARALLELTEMPERING_H
+#define PARALLELTEMPERING_H
+
+#include "SimulatedAnnealing.h"
+
+/**
+ * Parallel tempering (replica exchange). Replicas of the schedule, each
+ * with its own aggregates and random engine, run Metropolis moves at the
+ * fixed temperatures of a geometric ladder, spread over a pool of threads.
+ * After every round of EXCHANGE_INTERVAL moves per replica the threads
+ * meet once and neighbouring temperatures exchange configurations with
+ * the replica exchange acceptance rule. Exchanging a configuration is done
+ * by swapping the temperatures of the two replicas instead, so nothing is
+ * copied and replicas never touch each other's state. The best schedule
+ * of any replica is returned.
+ */
+class ParallelTempering : public SimulatedAnnealing
+{
+private:
+  int replicas;
+  int threads;
+
+protected:
+  double search(bool, SearchBudget &, State &) override;
+  HillClimb *clone() const override;
+
+public:
+  static const int DEFAULT_REPLICAS = 4;
+  static const int EXCHANGE_INTERVAL = 1000;     // moves per replica between exchange points
+  static constexpr double HOTTEST_SCALE = 0.05;  // hottest rung over the annealing start temperature
+  static constexpr double LADDER_RATIO = 0.1;    // coldest over hottest temperature
+
+  ParallelTempering(const DistanceMatrix &, int, int, int, double, int replicas, int threads);
+};
+
+#endif /* PARALLELTEMPERING_H */
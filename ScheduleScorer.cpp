@@ -0,0 +1,106 @@
+/* 
+ * File:   ScheduleScorer.cpp
+ * Author: Varun Srivastava
+ *
+ */
+
+#include <algorithm>
+
+#include "ScheduleScorer.h"
+#include "Kernels.h"
+#include "WorkerPool.h"
+
+// Similarity and competing sums of time slot t
+static void score_slot(const DistanceMatrix &matrix, const int *papers, int parallel_tracks, int papers_in_session,
+                       double *buffer, double &similar, double &competing)
+{
+    const int m = parallel_tracks * papers_in_session;
+    similar = competing = 0;
+    for (int a = 0; a + 1 < m; ++a)
+    {
+        // buffer[j] = d(papers[a], papers[a + 1 + j]) for the rest of the slot
+        const int rest = m - a - 1;
+        if (matrix.is_direct())
+            kernels().gather(buffer, matrix.row(papers[a], nullptr), papers + a + 1, rest);
+        else
+            for (int j = 0; j != rest; ++j)
+                buffer[j] = matrix(papers[a], papers[a + 1 + j]);
+
+        const int same = (a / papers_in_session + 1) * papers_in_session - a - 1; // later papers of the same session
+        similar += same - kernels().sum(buffer, same);
+        competing += kernels().sum(buffer + same, rest - same);
+    }
+}
+
+// The same sums for a sparse matrix. Every pair of the slot is at the default distance D except the
+// listed neighbours, which differ from it by their affinity D - d.
+static void score_sparse_slot(const DistanceMatrix &matrix, const int *papers, const int *position, int first, int parallel_tracks,
+                              int papers_in_session, double &similar, double &competing)
+{
+    const int m = parallel_tracks * papers_in_session;
+    const double D = matrix.get_default_distance();
+    double near_similar = 0, near_competing = 0;
+    for (int a = 0; a != m; ++a)
+    {
+        const int x = papers[a];
+        const int *near = matrix.neighbours(x);
+        const double *distances = matrix.neighbour_distances(x);
+        for (int e = 0; e != matrix.neighbour_count(x); ++e)
+        {
+            // Each pair once, from the paper placed first
+            const int b = position[near[e]] - first;
+            if (b <= a || b >= m)
+                continue;
+            if (b / papers_in_session == a / papers_in_session)
+                near_similar += D - distances[e];
+            else
+                near_competing += D - distances[e];
+        }
+    }
+    const double same_pairs = parallel_tracks * (static_cast<double>(papers_in_session) * (papers_in_session - 1) / 2);
+    const double competing_pairs = static_cast<double>(m) * (m - 1) / 2 - same_pairs;
+    similar = same_pairs * (1 - D) + near_similar;
+    competing = competing_pairs * D - near_competing;
+}
+
+double score_schedule(const DistanceMatrix &matrix, const std::vector<int> &schedule, int parallel_tracks, int sessions_in_track,
+                      int papers_in_session, double tradeoff_coefficient, int threads)
+{
+    const int m = parallel_tracks * papers_in_session;
+    std::vector<double> similar(sessions_in_track), competing(sessions_in_track);
+
+    std::vector<int> position;
+    if (matrix.is_sparse())
+    {
+        position.assign(matrix.size(), -1);
+        for (size_t i = 0; i != schedule.size(); ++i)
+            position[schedule[i]] = i;
+    }
+
+    auto score_slots = [&](int first, int step) {
+        std::vector<double> buffer(matrix.is_sparse() ? 0 : m);
+        for (int t = first; t < sessions_in_track; t += step)
+            if (matrix.is_sparse())
+                score_sparse_slot(matrix, schedule.data() + static_cast<size_t>(t) * m, position.data(), t * m, parallel_tracks,
+                                  papers_in_session, similar[t], competing[t]);
+            else
+                score_slot(matrix, schedule.data() + static_cast<size_t>(t) * m, parallel_tracks, papers_in_session, buffer.data(),
+                           similar[t], competing[t]);
+    };
+    if (threads <= 1 || sessions_in_track <= 1)
+        score_slots(0, 1);
+    else
+    {
+        WorkerPool pool(std::min(threads, sessions_in_track));
+        const int workers = pool.size();
+        pool.run([&](int w) { score_slots(w, workers); });
+    }
+
+    double score1 = 0, score2 = 0;
+    for (int t = 0; t != sessions_in_track; ++t)
+    {
+        score1 += similar[t];
+        score2 += competing[t];
+    }
+    return score1 + tradeoff_coefficient * score2;
+}
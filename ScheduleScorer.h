@@ -0,0 +1,26 @@
+/* 
+ * File:   ScheduleScorer.h
+ * Author: Varun Srivastava
+ *
+ */
+
+#ifndef SCHEDULESCORER_H
+#define SCHEDULESCORER_H
+
+#include <vector>
+
+#include "DistanceMatrix.h"
+
+// Score of a whole schedule, paper ids in slot, track, paper order as in
+// the search state and Conference, computed from scratch. Only pairs within
+// a time slot contribute, so for every paper of a slot the distances to the
+// later papers of the slot are gathered into a contiguous buffer and summed
+// with SIMD: the rest of its session gives the similarity term and the
+// later sessions the competing term. Time slots are split over the given
+// number of threads; the per slot sums are added in slot order so the
+// result does not depend on the thread count. A sparse matrix is scored
+// from the neighbours listed within each slot, O(n + listed pairs).
+double score_schedule(const DistanceMatrix &, const std::vector<int> &schedule, int parallel_tracks, int sessions_in_track,
+                      int papers_in_session, double tradeoff_coefficient, int threads = 1);
+
+#endif /* SCHEDULESCORER_H */
@@ -0,0 +1,102 @@
+/* 
+ * File:   SearchBudget.cpp
+ * Author: Varun Srivastava
+ *
+ */
+
+#include <algorithm>
+#include <limits>
+
+#include "SearchBudget.h"
+
+constexpr double SearchBudget::CHECK_PERIOD;
+
+SearchBudget::SearchBudget(Time::time_point deadline, const SearchOptions &options, std::atomic<bool> *stop, SearchTrace *trace)
+    : start(Time::now()), deadline(deadline), options(options), stop(stop), trace(trace),
+      best(std::numeric_limits<double>::lowest()), iterations(0), interval(1), checked_at(0),
+      last_check(start), elapsed_fraction(0), done(false), publish_due(false),
+      published(std::numeric_limits<double>::lowest()), last_publish(start)
+{
+    if (options.fixed_iterations)
+        next_check = options.max_iterations;
+    else
+    {
+        interval = options.check_interval > 0 ? options.check_interval : 1;
+        next_check = interval;
+        if (options.max_iterations > 0)
+            next_check = std::min(next_check, options.max_iterations);
+    }
+    done = options.fixed_iterations && options.max_iterations <= 0;
+}
+
+bool SearchBudget::check(long long upcoming)
+{
+    if (done)
+        return false;
+
+    if (options.max_iterations > 0 && upcoming > options.max_iterations)
+        done = true;
+    if (options.fixed_iterations)
+        return !done;
+
+    if (stop && *stop)
+        done = true;
+
+    auto now = Time::now();
+    if (now >= deadline)
+        done = true;
+    double total = std::chrono::duration_cast<double_seconds>(deadline - start).count();
+    elapsed_fraction = total > 0 ? std::min(1.0, std::chrono::duration_cast<double_seconds>(now - start).count() / total) : 1.0;
+
+    if (options.check_interval <= 0)
+    {
+        // Scale the interval towards CHECK_PERIOD, at most doubling per read
+        double elapsed = std::chrono::duration_cast<double_seconds>(now - last_check).count();
+        long long moves = std::max(1LL, iterations - checked_at);
+        double wanted = elapsed > 0 ? moves * CHECK_PERIOD / elapsed : 2.0 * interval;
+        interval = std::max(1LL, std::min(2 * interval, static_cast<long long>(wanted)));
+    }
+    last_check = now;
+    checked_at = iterations;
+    if (options.on_improvement && std::chrono::duration_cast<double_seconds>(now - last_publish).count() >= options.improvement_period)
+        publish_due = true;
+
+    next_check = iterations + interval;
+    if (options.max_iterations > 0)
+        next_check = std::min(next_check, options.max_iterations);
+    return !done;
+}
+
+void SearchBudget::resume(long long moves)
+{
+    iterations = checked_at = moves;
+    next_check = options.fixed_iterations ? options.max_iterations : iterations + interval;
+    if (options.max_iterations > 0)
+        next_check = std::min(next_check, options.max_iterations);
+}
+
+void SearchBudget::publish(double score, const std::vector<int> &state)
+{
+    options.on_improvement(score, state);
+    published = score;
+    publish_due = false;
+    last_publish = Time::now();
+}
+
+void SearchBudget::record_best(double score)
+{
+    best = score;
+    BestEvent event;
+    event.time = elapsed();
+    event.moves = iterations;
+    event.score = score;
+    trace->add(event);
+}
+
+double SearchBudget::progress() const
+{
+    double fraction = options.fixed_iterations ? 0 : elapsed_fraction;
+    if (options.max_iterations > 0)
+        fraction = std::max(fraction, std::min(1.0, static_cast<double>(iterations) / options.max_iterations));
+    return fraction;
+}
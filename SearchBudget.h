@@ -0,0 +1,138 @@
+/* 
+ * File:   SearchBudget.h
+ * Author: Varun Srivastava
+ *
+ */
+
+#ifndef SEARCHBUDGET_H
+#define SEARCHBUDGET_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "SearchTrace.h"
+
+typedef std::chrono::high_resolution_clock Time;
+typedef std::chrono::duration<double> double_seconds;
+
+// Receives states that improve on the ones it was given before, together with their score.
+// Workers of one search call it concurrently.
+typedef std::function<void(double, const std::vector<int> &)> ImprovementListener;
+
+// Settings of a search besides its time budget
+struct SearchOptions
+{
+  long long max_iterations = 0;  // moves per worker, 0 for no limit
+  bool fixed_iterations = false; // run exactly max_iterations moves and never read the clock
+  bool has_target = false;       // stop once a schedule scores target_score or better
+  double target_score = 0;
+  long long check_interval = 0; // moves between clock reads, 0 adapts it to the iteration rate
+  std::string trace_file;       // JSON lines trace of the search, empty for none
+  bool verify_scores = false;   // rescore the final state of every worker from scratch and report drift
+  std::string checkpoint_file;  // written every checkpoint_period seconds, empty for none
+  double checkpoint_period = 60;
+  bool resume = false; // continue the search saved in checkpoint_file
+  ImprovementListener on_improvement; // streams improving states while the search runs, empty for none
+  double improvement_period = 0.1;    // seconds between two states a worker streams
+};
+
+/**
+ * SearchBudget decides when a search worker stops. Reading the clock costs
+ * about as much as evaluating a move, so it is only read every few moves;
+ * the interval adapts so that reads happen roughly every CHECK_PERIOD.
+ * Workers of one search share a stop flag so that reaching the target
+ * score in one of them ends all of them. When given a trace, the budget
+ * also records every new best score the worker reports.
+ */
+class SearchBudget
+{
+private:
+  Time::time_point start;
+  Time::time_point deadline;
+  SearchOptions options;
+  std::atomic<bool> *stop;
+  SearchTrace *trace;
+  double best; // best reported score, only kept when tracing
+
+  long long iterations;
+  long long next_check;
+  long long interval;
+  long long checked_at; // iterations at the last clock read
+  Time::time_point last_check;
+  double elapsed_fraction; // share of the time budget used at the last clock read
+  bool done;
+  bool publish_due;         // the improvement listener may be given a state
+  double published;         // score of the last state given to it
+  Time::time_point last_publish;
+
+  // Reads the clock if due, upcoming is the number of the next move; false once it may not run
+  bool check(long long upcoming);
+  void record_best(double score);
+
+public:
+  // Time between two clock reads the adaptive interval aims for
+  static constexpr double CHECK_PERIOD = 1e-3;
+
+  SearchBudget(Time::time_point deadline, const SearchOptions &options, std::atomic<bool> *stop = nullptr,
+               SearchTrace *trace = nullptr);
+
+  // Counts the move about to be made, false if it may not run
+  bool next()
+  {
+    if (++iterations < next_check || check(iterations))
+      return true;
+    --iterations; // a move that may not run was not made
+    return false;
+  }
+
+  // Counts a batch of moves already made, e.g. by helper threads, false once no further move may run
+  bool next(long long moves)
+  {
+    if ((iterations += moves) + 1 < next_check)
+      return true;
+    return check(iterations + 1);
+  }
+
+  // False once the search has to stop, without counting a move
+  bool running() { return !done && (options.fixed_iterations || check(iterations + 1)); }
+
+  // Reports a reached score, stops every worker if it meets the target
+  void report(double score)
+  {
+    if (trace && score > best)
+      record_best(score);
+    if (options.has_target && score >= options.target_score)
+    {
+      done = true;
+      if (stop)
+        *stop = true;
+    }
+  }
+
+  // True if a state of this score should go to the improvement listener, cheap enough to ask every move
+  bool wants(double score) const { return publish_due && score > published; }
+
+  // Gives an improving state to the listener, at most once per improvement period
+  void publish(double score, const std::vector<int> &state);
+
+  long long get_iterations() const { return iterations; }
+  Time::time_point get_deadline() const { return deadline; }
+  const SearchOptions &get_options() const { return options; }
+
+  // Continues counting from the moves a resumed search had made
+  void resume(long long moves);
+
+  // Trace of this worker, null when not tracing
+  SearchTrace *get_trace() const { return trace; }
+
+  // Seconds since the budget was created, reads the clock
+  double elapsed() const { return std::chrono::duration_cast<double_seconds>(Time::now() - start).count(); }
+
+  // Share of the budget used so far in [0, 1], by iterations when they are limited and by time otherwise
+  double progress() const;
+};
+
+#endif /* SEARCHBUDGET_H */
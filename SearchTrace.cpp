@@ -0,0 +1,90 @@
+/* 
+ * File:   SearchTrace.cpp
+ * Author: Varun Srivastava
+ *
+ */
+
+#include <cstdio>
+
+#include "SearchTrace.h"
+
+static void write_stats(std::FILE *out, const char *event, int worker, const SearchStats &stats)
+{
+    std::fprintf(out, "{\"event\": \"%s\", ", event);
+    if (worker >= 0)
+        std::fprintf(out, "\"worker\": %d, ", worker);
+    std::fprintf(out, "\"evaluated\": %lld, \"uphill\": %lld, \"flat\": %lld, \"downhill\": %lld, \"restarts\": %lld}\n",
+                 stats.evaluated, stats.uphill, stats.flat, stats.downhill, stats.restarts);
+}
+
+void SearchTrace::add(const BestEvent &event)
+{
+    best.push_back(event);
+    if (writer && best.size() + restarts.size() >= TraceWriter::BUFFERED_EVENTS)
+        writer->flush(*this);
+}
+
+void SearchTrace::add(const RestartEvent &event)
+{
+    restarts.push_back(event);
+    if (writer && best.size() + restarts.size() >= TraceWriter::BUFFERED_EVENTS)
+        writer->flush(*this);
+}
+
+TraceWriter::TraceWriter(const std::string &filename) : out(std::fopen(filename.c_str(), "w")), failed(false)
+{
+}
+
+TraceWriter::~TraceWriter()
+{
+    if (out)
+        std::fclose(out);
+}
+
+void TraceWriter::flush(SearchTrace &trace)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (out)
+    {
+        for (const BestEvent &e : trace.best)
+            std::fprintf(out, "{\"event\": \"best\", \"worker\": %d, \"time\": %.6f, \"moves\": %lld, \"score\": %.9g}\n",
+                         trace.worker, e.time, e.moves, e.score);
+        for (std::size_t r = 0; r != trace.restarts.size(); ++r)
+        {
+            const RestartEvent &e = trace.restarts[r];
+            std::fprintf(out,
+                         "{\"event\": \"restart\", \"worker\": %d, \"index\": %zu, \"start\": %.6f, \"duration\": %.6f, "
+                         "\"moves\": %lld, \"initial_score\": %.9g, \"final_score\": %.9g}\n",
+                         trace.worker, trace.restarts_written + r, e.start, e.duration, e.moves, e.initial_score, e.final_score);
+        }
+        failed = failed || std::ferror(out);
+    }
+    trace.restarts_written += trace.restarts.size();
+    trace.best.clear();
+    trace.restarts.clear();
+}
+
+bool TraceWriter::finish(std::vector<SearchTrace> &traces)
+{
+    SearchStats total;
+    for (std::size_t w = 0; w != traces.size(); ++w)
+    {
+        traces[w].worker = w;
+        flush(traces[w]);
+        if (out)
+            write_stats(out, "worker", w, traces[w].stats);
+        total.merge(traces[w].stats);
+    }
+    if (!out)
+        return false;
+    write_stats(out, "total", -1, total);
+    bool written = !failed && std::fclose(out) == 0;
+    out = nullptr;
+    return written;
+}
+
+bool write_search_trace(const std::string &filename, std::vector<SearchTrace> &traces)
+{
+    TraceWriter writer(filename);
+    return writer.finish(traces);
+}
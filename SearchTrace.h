@@ -0,0 +1,108 @@
+/* 
+ * File:   SearchTrace.h
+ * Author: Varun Srivastava
+ *
+ */
+
+#ifndef SEARCHTRACE_H
+#define SEARCHTRACE_H
+
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Counters of one search worker. Every worker counts into its own copy,
+// they are only added up once the workers are done.
+struct SearchStats
+{
+  long long evaluated = 0; // moves whose score increment was computed
+  long long uphill = 0;    // accepted moves that raised the score
+  long long flat = 0;      // accepted moves that left it unchanged
+  long long downhill = 0;  // accepted moves that lowered it
+  long long restarts = 0;  // fresh starts or perturbations of the current state
+  long long placed = 0;    // papers a warm start put in the open positions
+  long long moved = 0;     // papers a warm start left outside the session they were placed in
+
+  // Counts an accepted move by its score increment
+  void accepted(double delta) { ++(delta > 0 ? uphill : delta < 0 ? downhill : flat); }
+
+  void merge(const SearchStats &other)
+  {
+    evaluated += other.evaluated;
+    uphill += other.uphill;
+    flat += other.flat;
+    downhill += other.downhill;
+    restarts += other.restarts;
+    placed += other.placed;
+    moved += other.moved;
+  }
+};
+
+// A new best score of a worker
+struct BestEvent
+{
+  double time; // seconds since the worker started
+  long long moves;
+  double score;
+};
+
+// One restart of a worker, from its initial to its final state
+struct RestartEvent
+{
+  double start, duration; // seconds
+  long long moves;
+  double initial_score, final_score;
+};
+
+class TraceWriter;
+
+// What one worker did, only recorded when a trace was asked for. Events are
+// buffered until the writer takes them, or until the end without a writer.
+struct SearchTrace
+{
+  SearchStats stats;
+  std::vector<BestEvent> best;
+  std::vector<RestartEvent> restarts;
+  std::size_t restarts_written = 0; // restarts the writer already took, they number the later ones
+  TraceWriter *writer = nullptr;
+  int worker = 0;
+
+  void add(const BestEvent &event);
+  void add(const RestartEvent &event);
+};
+
+/**
+ * TraceWriter writes the traces of the workers of a search as JSON lines
+ * while it runs. A worker hands in its buffered events whenever
+ * BUFFERED_EVENTS of them have piled up, so a long run with a trace keeps
+ * a bounded number of events in memory. The counters of every worker and
+ * their total follow at the end.
+ */
+class TraceWriter
+{
+private:
+  std::FILE *out;
+  bool failed;
+  std::mutex mutex;
+
+public:
+  explicit TraceWriter(const std::string &filename);
+  ~TraceWriter();
+
+  TraceWriter(const TraceWriter &) = delete;
+  TraceWriter &operator=(const TraceWriter &) = delete;
+
+  // Writes the buffered events of a worker and clears them
+  void flush(SearchTrace &trace);
+
+  // Writes what is left and the counters of every worker, returns false if the file could not be written
+  bool finish(std::vector<SearchTrace> &traces);
+
+  static const std::size_t BUFFERED_EVENTS = 4096;
+};
+
+// Writes the traces of all workers as JSON lines, returns false if the file cannot be written
+bool write_search_trace(const std::string &filename, std::vector<SearchTrace> &traces);
+
+#endif /* SEARCHTRACE_H */
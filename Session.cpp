@@ -4,47 +4,24 @@
  * 
  */
 
-#include <errno.h>
-#include <vector>
-
 #include "Session.h"
 
 Session::Session()
 {
+    papers = nullptr;
     papersInSession = 0;
 }
 
-Session::Session(int papersInSession)
+Session::Session(int *papers, int papersInSession)
 {
+    this->papers = papers;
     this->papersInSession = papersInSession;
-    initPapers(papersInSession);
-}
-
-void Session::initPapers(int papersInSession)
-{
-    this->papers = (int *)malloc(sizeof(int) * papersInSession);
-    for (int i = 0; i < papersInSession; i++)
-    {
-        papers[i] = -1;
-    }
-}
-
-int Session::getNumberOfPapers()
-{
-    return papersInSession;
 }
 
-int Session::getPaper(int index)
+void Session::indexError(const char *where)
 {
-    if (index < papersInSession)
-    {
-        return papers[index];
-    }
-    else
-    {
-        cout << "Index out of bound - Session::getPaper" << endl;
-        exit(0);
-    }
+    cout << "Index out of bound - " << where << endl;
+    exit(0);
 }
 
 void Session::setPaper(int index, int paperId)
@@ -55,12 +32,11 @@ void Session::setPaper(int index, int paperId)
     }
     else
     {
-        cout << "Index out of bound - Session::setPaper" << endl;
-        exit(0);
+        indexError("Session::setPaper");
     }
 }
 
-void Session::printSession()
+void Session::printSession() const
 {
     for (int i = 0; i < papersInSession; i++)
     {
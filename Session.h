@@ -12,7 +12,9 @@
 using namespace std;
 
 /**
- * Session holds an array of papers.
+ * Session is a view of the papers of one session inside the schedule
+ * stored by Conference. It does not own the papers, copies of it refer
+ * to the same papers.
  * 
  * @author Kapil Thakkar
  *
@@ -22,32 +24,31 @@ class Session
 {
 
   private:
-    int *papers;         // array of paper
+    int *papers;         // first paper of the session
     int papersInSession; // number of papers
 
+    static void indexError(const char *where);
+
   public:
     Session();
 
     /**
      * Constructor
      * 
+     * @param papers is the first of the papers of the session.
      * @param papersInSession the number of papers in a session.
      */
-    Session(int papersInSession);
-
-    /**
-     * Initialize the array of papers.
-     * 
-     * @param papersInSession the number of papers in a session.
-     */
-    void initPapers(int papersInSession);
+    Session(int *papers, int papersInSession);
 
     /**
      * Get the number of papers in a session.
      * 
      * @return the number of papers.
      */
-    int getNumberOfPapers();
+    int getNumberOfPapers() const
+    {
+        return papersInSession;
+    }
 
     /**
      * Get the id of the paper at the specified index
@@ -55,7 +56,12 @@ class Session
      * @param index the index of the paper
      * @return the id of the paper
      */
-    int getPaper(int index);
+    int getPaper(int index) const
+    {
+        if (index >= papersInSession)
+            indexError("Session::getPaper");
+        return papers[index];
+    }
 
     /**
      * Set the paper id at the specified index.
@@ -69,7 +75,7 @@ class Session
      * Print the papers present in current session 
      *
      */
-    void printSession();
+    void printSession() const;
 };
 
 #endif /* SESSION_H */
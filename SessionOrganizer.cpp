@@ -5,9 +5,37 @@
  */
 
 #include "SessionOrganizer.h"
-#include "Util.h"
+#include "BinaryMatrix.h"
+#include "ScheduleScorer.h"
 #include "HillClimb.h"
+#include "TabuSearch.h"
+#include "ParallelTempering.h"
+#include "MemeticSearch.h"
 #include <vector>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <memory>
+#include <sstream>
+
+bool parse_search_engine(const char *name, SearchEngine &engine)
+{
+    if (strcmp(name, "hillclimb") == 0)
+        engine = ENGINE_HILL_CLIMB;
+    else if (strcmp(name, "anneal") == 0)
+        engine = ENGINE_ANNEALING;
+    else if (strcmp(name, "tabu") == 0)
+        engine = ENGINE_TABU;
+    else if (strcmp(name, "tempering") == 0)
+        engine = ENGINE_TEMPERING;
+    else if (strcmp(name, "memetic") == 0)
+        engine = ENGINE_MEMETIC;
+    else
+        return false;
+    return true;
+}
 
 SessionOrganizer::SessionOrganizer()
 {
@@ -16,98 +44,507 @@ SessionOrganizer::SessionOrganizer()
     sessionsInTrack = 0;
     processingTimeInMinutes = 0;
     tradeoffCoefficient = 1.0;
+    threads = 1;
+    engine = ENGINE_HILL_CLIMB;
+    coolingSchedule = COOLING_GEOMETRIC;
+    greedyInitialization = false;
+    replicas = 0;
+    islands = 0;
+    maxMovedPapers = -1;
+    inputError = nullptr;
+    conference = nullptr;
 }
 
-SessionOrganizer::SessionOrganizer(string filename)
+SessionOrganizer::SessionOrganizer(string filename, int threads, MatrixFormat format, string *error)
 {
+    this->threads = threads;
+    this->matrixFormat = format;
+    this->inputError = error;
+    engine = ENGINE_HILL_CLIMB;
+    coolingSchedule = COOLING_GEOMETRIC;
+    greedyInitialization = false;
+    replicas = 0;
+    islands = 0;
+    maxMovedPapers = -1;
     readInInputFile(filename);
+    conference = error && !error->empty() ? nullptr : new Conference(parallelTracks, sessionsInTrack, papersInSession);
+    inputError = nullptr;
+}
+
+SessionOrganizer::SessionOrganizer(const SessionOrganizer &input, int threads)
+{
+    this->threads = threads;
+    this->matrixFormat = input.matrixFormat;
+    engine = ENGINE_HILL_CLIMB;
+    coolingSchedule = COOLING_GEOMETRIC;
+    greedyInitialization = false;
+    replicas = 0;
+    islands = 0;
+    maxMovedPapers = -1;
+    inputError = nullptr;
+    parallelTracks = input.parallelTracks;
+    papersInSession = input.papersInSession;
+    sessionsInTrack = input.sessionsInTrack;
+    processingTimeInMinutes = input.processingTimeInMinutes;
+    tradeoffCoefficient = input.tradeoffCoefficient;
+    distanceMatrix = input.distanceMatrix.view();
     conference = new Conference(parallelTracks, sessionsInTrack, papersInSession);
 }
 
+SessionOrganizer::~SessionOrganizer()
+{
+    delete conference;
+}
+
+HillClimb *SessionOrganizer::createSearch(int threads, int &workers)
+{
+    workers = threads;
+    if (engine == ENGINE_TABU)
+    {
+        // One tabu trajectory, its neighbourhood scan uses all threads
+        workers = 1;
+        return new TabuSearch(distanceMatrix, parallelTracks, sessionsInTrack, papersInSession, tradeoffCoefficient, threads);
+    }
+    else if (engine == ENGINE_TEMPERING)
+    {
+        // One replica exchange run, its replicas are spread over all threads
+        int count = replicas > 0 ? replicas : max(ParallelTempering::DEFAULT_REPLICAS, threads);
+        workers = 1;
+        return new ParallelTempering(distanceMatrix, parallelTracks, sessionsInTrack, papersInSession, tradeoffCoefficient, count, threads);
+    }
+    else if (engine == ENGINE_MEMETIC)
+    {
+        // One island model, its islands are spread over all threads
+        int count = islands > 0 ? islands : max(MemeticSearch::DEFAULT_ISLANDS, threads);
+        workers = 1;
+        return new MemeticSearch(distanceMatrix, parallelTracks, sessionsInTrack, papersInSession, tradeoffCoefficient, count, threads);
+    }
+    else if (engine == ENGINE_ANNEALING)
+    {
+        return new SimulatedAnnealing(distanceMatrix, parallelTracks, sessionsInTrack, papersInSession, tradeoffCoefficient, coolingSchedule);
+    }
+    return new HillClimb(distanceMatrix, parallelTracks, sessionsInTrack, papersInSession, tradeoffCoefficient);
+}
+
 void SessionOrganizer::organizePapers()
 {
     const int ANSWER_TO_THE_UNIVERSE = 43;
-    HillClimb hill_climb(distanceMatrix, parallelTracks, sessionsInTrack, papersInSession, tradeoffCoefficient);
-    auto state = hill_climb.hill_climb(true, processingTimeInMinutes * 0.95, ANSWER_TO_THE_UNIVERSE);
-    int paperCounter = 0;
-    for (int i = 0; i < conference->getSessionsInTrack(); i++)
+    if (!warmStartFile.empty())
+    {
+        // Local repair of a published organization, the same for every engine
+        HillClimb repair(distanceMatrix, parallelTracks, sessionsInTrack, papersInSession, tradeoffCoefficient);
+        vector<int> schedule = parseOrganization(warmStartFile, &withdrawnPapers);
+        conference->setSchedule(repair.warm_start(schedule, getSearchTime(), maxMovedPapers, searchOptions));
+        searchStats = repair.get_stats();
+        return;
+    }
+    int workers;
+    unique_ptr<HillClimb> search(createSearch(threads, workers));
+    if (!searchOptions.checkpoint_file.empty())
     {
-        for (int j = 0; j < conference->getParallelTracks(); j++)
+        // Only the restart loop of the plain hill climb knows how to save and restore itself
+        if (engine != ENGINE_HILL_CLIMB)
         {
-            for (int k = 0; k < conference->getPapersInSession(); k++)
-            {
-                conference->setPaper(j, i, k, state[paperCounter]);
-                paperCounter++;
-            }
+            cout << "Checkpoints are only supported by the hillclimb engine" << endl;
+            exit(0);
         }
+        if (searchOptions.resume)
+            resumeSearch(*search, workers);
     }
+    // The search state has the schedule layout of Conference, it is handed over as is
+    conference->setSchedule(search->hill_climb(!greedyInitialization, getSearchTime(), ANSWER_TO_THE_UNIVERSE, workers, searchOptions));
+    searchStats = search->get_stats();
     return;
 }
 
+vector<int> SessionOrganizer::searchOrganization(int seed, double minutes)
+{
+    int workers;
+    unique_ptr<HillClimb> search(createSearch(1, workers));
+    return search->hill_climb(!greedyInitialization, minutes, seed, 1, searchOptions);
+}
+
+const vector<int> &SessionOrganizer::getOrganization()
+{
+    return conference->getSchedule();
+}
+
+void SessionOrganizer::setOrganization(vector<int> schedule)
+{
+    conference->setSchedule(std::move(schedule));
+}
+
+const SearchStats &SessionOrganizer::getSearchStats()
+{
+    return searchStats;
+}
+
+double SessionOrganizer::getSearchTime()
+{
+    // The rest of the processing time is left for reading the input and writing the output
+    return processingTimeInMinutes * 0.95;
+}
+
+void SessionOrganizer::resumeSearch(HillClimb &search, int workers)
+{
+    if (!ifstream(searchOptions.checkpoint_file.c_str()))
+    {
+        cout << "No checkpoint to resume from, starting a new search" << endl;
+        return;
+    }
+    Checkpoint checkpoint;
+    string error = read_checkpoint(searchOptions.checkpoint_file, checkpoint);
+    if (!error.empty())
+    {
+        cout << "Unable to resume: " << error << endl;
+        exit(0);
+    }
+    if (checkpoint.parallel_tracks != parallelTracks || checkpoint.sessions_in_track != sessionsInTrack ||
+        checkpoint.papers_in_session != papersInSession)
+    {
+        cout << "Unable to resume: the checkpoint is of a conference of a different shape" << endl;
+        exit(0);
+    }
+    if ((int)checkpoint.workers.size() != max(1, workers))
+    {
+        cout << "Unable to resume: the checkpoint was written by " << checkpoint.workers.size() << " threads" << endl;
+        exit(0);
+    }
+    search.resume(checkpoint);
+}
+
+void SessionOrganizer::setTradeoffCoefficient(double tradeoffCoefficient)
+{
+    this->tradeoffCoefficient = tradeoffCoefficient;
+}
+
+void SessionOrganizer::setProcessingTime(double minutes)
+{
+    this->processingTimeInMinutes = minutes;
+}
+
+int SessionOrganizer::getParallelTracks()
+{
+    return parallelTracks;
+}
+
+int SessionOrganizer::getSessionsInTrack()
+{
+    return sessionsInTrack;
+}
+
+int SessionOrganizer::getPapersInSession()
+{
+    return papersInSession;
+}
+
+void SessionOrganizer::setThreads(int threads)
+{
+    this->threads = threads;
+}
+
+void SessionOrganizer::setSearchOptions(const SearchOptions &options)
+{
+    this->searchOptions = options;
+}
+
+void SessionOrganizer::setEngine(SearchEngine engine, CoolingSchedule coolingSchedule)
+{
+    this->engine = engine;
+    this->coolingSchedule = coolingSchedule;
+}
+
+void SessionOrganizer::setGreedyInitialization(bool greedy)
+{
+    this->greedyInitialization = greedy;
+}
+
+void SessionOrganizer::setReplicas(int replicas)
+{
+    this->replicas = replicas;
+}
+
+void SessionOrganizer::setIslands(int islands)
+{
+    this->islands = islands;
+}
+
+void SessionOrganizer::setWarmStart(string filename, const vector<int> &withdrawn, int maxMoved)
+{
+    this->warmStartFile = filename;
+    this->withdrawnPapers = withdrawn;
+    this->maxMovedPapers = maxMoved;
+}
+
 void SessionOrganizer::readInInputFile(string filename)
 {
-    vector<string> lines;
-    string line;
-    ifstream myfile(filename.c_str());
-    if (myfile.is_open())
+    MappedFile &myfile = inputFile;
+    if (!myfile.open(filename))
+    {
+        rejectInput("Unable to open input file");
+        return;
+    }
+    if (is_binary_matrix(myfile.begin(), myfile.size()))
+    {
+        readInBinaryFile();
+        return;
+    }
+    vector<const char *> lines = index_lines(myfile.begin(), myfile.end());
+    int lineCount = lines.size() - 1;
+
+    if (6 > lineCount)
+    {
+        rejectInput("Not enough information given, check format of input file");
+        return;
+    }
+
+    processingTimeInMinutes = atof(string(lines[0], lines[1]).c_str());
+    papersInSession = atoi(string(lines[1], lines[2]).c_str());
+    parallelTracks = atoi(string(lines[2], lines[3]).c_str());
+    sessionsInTrack = atoi(string(lines[3], lines[4]).c_str());
+    tradeoffCoefficient = atof(string(lines[4], lines[5]).c_str());
+    if (papersInSession <= 0 || parallelTracks <= 0 || sessionsInTrack <= 0)
+    {
+        rejectInput("Not enough information given, the conference needs at least one paper in a session, track and time slot");
+        return;
+    }
+
+    if (string(lines[5], lines[6]).compare(0, 9, "embedding") == 0)
+    {
+        readInFeatures(lines);
+        myfile.close();
+        return;
+    }
+    if (string(lines[5], lines[6]).compare(0, 10, "neighbours") == 0)
     {
-        while (getline(myfile, line))
+        readInNeighbours(lines);
+        myfile.close();
+        return;
+    }
+
+    int n = lineCount - 5;
+    DistanceMatrix tempDistanceMatrix(n, matrixFormat);
+
+    // Rows are parsed in place from the mapping, in contiguous blocks per thread.
+    // Reduced storage parses into a scratch row first and converts it.
+    int workers = max(1, min(threads, n / 64));
+    atomic<bool> malformed(false);
+    vector<double> rowErrors(workers, 0.0);
+    auto parseRows = [&](int first, int last, int worker) {
+        vector<double> buffer(tempDistanceMatrix.is_direct() ? 0 : n);
+        for (int i = first; i < last && !malformed; i++)
         {
-            //cout<<"Line read:"<<line<<endl;
-            lines.push_back(line);
+            double *row = tempDistanceMatrix.is_direct() ? tempDistanceMatrix.row(i) : buffer.data();
+            if (!parse_row(lines[i + 5], lines[i + 6], row, n))
+                malformed = true;
+            else if (!tempDistanceMatrix.is_direct())
+                rowErrors[worker] = max(rowErrors[worker], tempDistanceMatrix.set_row(i, row));
         }
-        myfile.close();
+    };
+    vector<thread> pool;
+    for (int w = 1; w < workers; w++)
+    {
+        pool.emplace_back(parseRows, (long long)n * w / workers, (long long)n * (w + 1) / workers, w);
     }
-    else
+    parseRows(0, n / workers, 0);
+    for (auto &t : pool)
     {
-        cout << "Unable to open input file";
-        exit(0);
+        t.join();
+    }
+    if (malformed)
+    {
+        rejectInput("The similarity matrix does not have the correct format.");
+        return;
+    }
+    tempDistanceMatrix.set_max_error(*max_element(rowErrors.begin(), rowErrors.end()));
+    distanceMatrix = std::move(tempDistanceMatrix);
+    myfile.close();
+
+    int numberOfPapers = n;
+    int slots = parallelTracks * papersInSession * sessionsInTrack;
+    if (slots != numberOfPapers)
+    {
+        rejectInput("More papers than slots available! slots:" + to_string(slots) + " num papers:" + to_string(numberOfPapers) + "\n");
+        return;
     }
+}
 
-    if (6 > lines.size())
+void SessionOrganizer::readInFeatures(const vector<const char *> &lines)
+{
+    istringstream header(string(lines[5], lines[6]));
+    string keyword, metricName;
+    int dimensions = 0;
+    FeatureMetric metric;
+    if (!(header >> keyword >> metricName >> dimensions) || keyword != "embedding" ||
+        !parse_feature_metric(metricName.c_str(), metric) || dimensions <= 0)
     {
-        cout << "Not enough information given, check format of input file";
-        exit(0);
+        rejectInput("The embedding line has to be: embedding cosine|euclidean <dimensions>");
+        return;
+    }
+
+    int n = (int)lines.size() - 7;
+    int slots = parallelTracks * papersInSession * sessionsInTrack;
+    if (slots != n)
+    {
+        rejectInput("More papers than slots available! slots:" + to_string(slots) + " num papers:" + to_string(n) + "\n");
+        return;
     }
+    DistanceMatrix features(n, dimensions, metric);
 
-    processingTimeInMinutes = atof(lines[0].c_str());
-    papersInSession = atoi(lines[1].c_str());
-    parallelTracks = atoi(lines[2].c_str());
-    sessionsInTrack = atoi(lines[3].c_str());
-    tradeoffCoefficient = atof(lines[4].c_str());
+    // Vectors are parsed in contiguous blocks per thread and narrowed to floats
+    int workers = max(1, min(threads, n / 64));
+    atomic<bool> malformed(false);
+    auto parseVectors = [&](int first, int last) {
+        vector<double> buffer(dimensions);
+        for (int i = first; i < last && !malformed; i++)
+        {
+            if (!parse_row(lines[i + 6], lines[i + 7], buffer.data(), dimensions))
+            {
+                malformed = true;
+                break;
+            }
+            float *vector = features.features(i);
+            for (int j = 0; j < dimensions; j++)
+                vector[j] = (float)buffer[j];
+        }
+    };
+    vector<thread> pool;
+    for (int w = 1; w < workers; w++)
+    {
+        pool.emplace_back(parseVectors, (long long)n * w / workers, (long long)n * (w + 1) / workers);
+    }
+    parseVectors(0, n / workers);
+    for (auto &t : pool)
+    {
+        t.join();
+    }
+    if (malformed)
+    {
+        rejectInput("The embedding vectors do not have " + to_string(dimensions) + " numbers each.");
+        return;
+    }
+    features.finish_features();
+    distanceMatrix = std::move(features);
+}
 
-    int n = lines.size() - 5;
-    double **tempDistanceMatrix = new double *[n];
-    for (int i = 0; i < n; ++i)
+void SessionOrganizer::readInNeighbours(const vector<const char *> &lines)
+{
+    istringstream header(string(lines[5], lines[6]));
+    string keyword;
+    double defaultDistance;
+    if (!(header >> keyword >> defaultDistance) || keyword != "neighbours" || !(defaultDistance >= 0 && defaultDistance <= 1))
     {
-        tempDistanceMatrix[i] = new double[n];
+        rejectInput("The neighbours line has to be: neighbours <default distance between 0 and 1>");
+        return;
     }
 
-    for (int i = 0; i < n; i++)
+    int n = (int)lines.size() - 7;
+    int slots = parallelTracks * papersInSession * sessionsInTrack;
+    if (slots != n)
     {
-        string tempLine = lines[i + 5];
-        // std::vector<string> elements(n);
-        string* elements = new string[n];
-        splitString(tempLine, " ", elements, n);
-        for (int j = 0; j < n; j++)
+        rejectInput("More papers than slots available! slots:" + to_string(slots) + " num papers:" + to_string(n) + "\n");
+        return;
+    }
+
+    // Each line lists pairs of a neighbour and its distance, parsed in contiguous blocks per thread
+    vector<vector<Neighbour>> neighbours(n);
+    int workers = max(1, min(threads, n / 64));
+    atomic<int> malformed(-1);
+    auto parseLists = [&](int first, int last) {
+        vector<double> numbers;
+        for (int i = first; i < last && malformed < 0; i++)
         {
-            tempDistanceMatrix[i][j] = atof(elements[j].c_str());
+            bool valid = parse_numbers(lines[i + 6], lines[i + 7], numbers) && numbers.size() % 2 == 0;
+            for (size_t j = 0; valid && j != numbers.size(); j += 2)
+            {
+                // Papers are whole numbers below n and distances lie in [0, 1], NaN fails both comparisons
+                valid = numbers[j] >= 0 && numbers[j] < n && numbers[j] == floor(numbers[j]) &&
+                        numbers[j + 1] >= 0 && numbers[j + 1] <= 1;
+                if (valid)
+                    neighbours[i].push_back(Neighbour{(int)numbers[j], numbers[j + 1]});
+            }
+            if (!valid)
+                malformed = i;
         }
+    };
+    vector<thread> pool;
+    for (int w = 1; w < workers; w++)
+    {
+        pool.emplace_back(parseLists, (long long)n * w / workers, (long long)n * (w + 1) / workers);
+    }
+    parseLists(0, n / workers);
+    for (auto &t : pool)
+    {
+        t.join();
+    }
+    if (malformed >= 0)
+    {
+        rejectInput("The neighbours of paper " + to_string(malformed.load()) + " are not pairs of a paper and a distance between 0 and 1.");
+        return;
+    }
+    distanceMatrix = DistanceMatrix(n, defaultDistance, neighbours);
+}
 
-        delete[] elements;
+void SessionOrganizer::rejectInput(const string &message)
+{
+    if (inputError == nullptr)
+    {
+        cout << message;
+        exit(0);
     }
-    distanceMatrix = tempDistanceMatrix;
+    *inputError = message.substr(0, message.find_last_not_of('\n') + 1);
+}
 
-    int numberOfPapers = n;
+void SessionOrganizer::setRowCache(int rows)
+{
+    distanceMatrix.set_row_cache(rows);
+}
+
+void SessionOrganizer::readInBinaryFile()
+{
+    string problem = validate_binary_matrix(inputFile.begin(), inputFile.size());
+    if (!problem.empty())
+    {
+        rejectInput("Not enough information given, " + problem);
+        return;
+    }
+
+    BinaryMatrixHeader header;
+    memcpy(&header, inputFile.begin(), sizeof(header));
+    processingTimeInMinutes = header.processing_time;
+    papersInSession = header.papers_in_session;
+    parallelTracks = header.parallel_tracks;
+    sessionsInTrack = header.sessions_in_track;
+    tradeoffCoefficient = header.tradeoff_coefficient;
+
+    MatrixFormat format(static_cast<ElementType>(header.element_type), static_cast<MatrixLayout>(header.layout));
+    distanceMatrix = DistanceMatrix(inputFile.begin() + sizeof(header), header.n, header.stride, format, header.max_error);
+
+    int numberOfPapers = header.n;
     int slots = parallelTracks * papersInSession * sessionsInTrack;
     if (slots != numberOfPapers)
     {
-        cout << "More papers than slots available! slots:" << slots << " num papers:" << numberOfPapers << endl;
+        rejectInput("More papers than slots available! slots:" + to_string(slots) + " num papers:" + to_string(numberOfPapers) + "\n");
+        return;
+    }
+}
+
+void SessionOrganizer::writeBinaryFile(string filename)
+{
+    if (distanceMatrix.has_features() || distanceMatrix.is_sparse())
+    {
+        cout << "Only inputs with a full distance matrix can be converted" << endl;
+        exit(0);
+    }
+    if (!write_binary_matrix(filename, distanceMatrix, processingTimeInMinutes, papersInSession,
+                             parallelTracks, sessionsInTrack, tradeoffCoefficient))
+    {
+        cout << "Unable to write binary file " << filename << endl;
         exit(0);
     }
 }
 
-double **SessionOrganizer::getDistanceMatrix()
+const DistanceMatrix &SessionOrganizer::getDistanceMatrix()
 {
     return distanceMatrix;
 }
@@ -119,52 +556,103 @@ void SessionOrganizer::printSessionOrganiser(char *filename)
 
 double SessionOrganizer::scoreOrganization()
 {
-    // Sum of pairwise similarities per session.
-    double score1 = 0.0;
-    for (int i = 0; i < conference->getParallelTracks(); i++)
+    return scoreOrganization(conference->getSchedule());
+}
+
+double SessionOrganizer::scoreOrganization(const vector<int> &schedule)
+{
+    return score_schedule(distanceMatrix, schedule, parallelTracks, sessionsInTrack, papersInSession, tradeoffCoefficient, threads);
+}
+
+vector<int> SessionOrganizer::parseOrganization(string filename, const vector<int> *withdrawn)
+{
+    ifstream in(filename.c_str());
+    if (!in)
     {
-        Track tmpTrack = conference->getTrack(i);
-        for (int j = 0; j < tmpTrack.getNumberOfSessions(); j++)
-        {
-            Session tmpSession = tmpTrack.getSession(j);
-            for (int k = 0; k < tmpSession.getNumberOfPapers(); k++)
-            {
-                int index1 = tmpSession.getPaper(k);
-                for (int l = k + 1; l < tmpSession.getNumberOfPapers(); l++)
-                {
-                    int index2 = tmpSession.getPaper(l);
-                    score1 += 1 - distanceMatrix[index1][index2];
-                }
-            }
-        }
+        cout << "Unable to read organization file " << filename << endl;
+        exit(0);
     }
 
-    // Sum of distances for competing papers.
-    double score2 = 0.0;
-    for (int i = 0; i < conference->getParallelTracks(); i++)
+    // One line per time slot, tracks separated by '|'
+    const int n = parallelTracks * sessionsInTrack * papersInSession;
+    vector<int> schedule;
+    schedule.reserve(n);
+    vector<bool> seen(n, false), removed(n, false);
+    if (withdrawn)
+        for (int paper : *withdrawn)
+            if (paper >= 0 && paper < n)
+                removed[paper] = true;
+    string line;
+    int slot = 0;
+    while (getline(in, line))
     {
-        Track tmpTrack1 = conference->getTrack(i);
-        for (int j = 0; j < tmpTrack1.getNumberOfSessions(); j++)
+        if (line.find_first_not_of(" \t\r") == string::npos)
+            continue;
+        if (slot == sessionsInTrack)
         {
-            Session tmpSession1 = tmpTrack1.getSession(j);
-            for (int k = 0; k < tmpSession1.getNumberOfPapers(); k++)
+            cout << "Organization has more than " << sessionsInTrack << " time slots" << endl;
+            exit(0);
+        }
+        int track = 0;
+        size_t start = 0;
+        while (true)
+        {
+            size_t end = line.find('|', start);
+            istringstream papers(line.substr(start, end == string::npos ? string::npos : end - start));
+            int paper, count = 0;
+            while (papers >> paper)
             {
-                int index1 = tmpSession1.getPaper(k);
-
-                // Get competing papers.
-                for (int l = i + 1; l < conference->getParallelTracks(); l++)
+                // Withdrawn papers, and with changes allowed those beyond the input, leave a hole
+                if (withdrawn && (paper < 0 || paper >= n || removed[paper]))
                 {
-                    Track tmpTrack2 = conference->getTrack(l);
-                    Session tmpSession2 = tmpTrack2.getSession(j);
-                    for (int m = 0; m < tmpSession2.getNumberOfPapers(); m++)
-                    {
-                        int index2 = tmpSession2.getPaper(m);
-                        score2 += distanceMatrix[index1][index2];
-                    }
+                    schedule.push_back(-1);
+                    count++;
+                    continue;
                 }
+                if (paper < 0 || paper >= n || seen[paper])
+                {
+                    cout << "Organization has an invalid or repeated paper " << paper << endl;
+                    exit(0);
+                }
+                seen[paper] = true;
+                schedule.push_back(paper);
+                count++;
             }
+            if (count != papersInSession || !papers.eof())
+            {
+                cout << "Organization session " << track << " of time slot " << slot << " does not hold " << papersInSession
+                     << " papers" << endl;
+                exit(0);
+            }
+            track++;
+            if (end == string::npos)
+                break;
+            start = end + 1;
+        }
+        if (track != parallelTracks)
+        {
+            cout << "Organization time slot " << slot << " does not have " << parallelTracks << " tracks" << endl;
+            exit(0);
         }
+        slot++;
+    }
+    if (slot != sessionsInTrack)
+    {
+        cout << "Organization has " << slot << " instead of " << sessionsInTrack << " time slots" << endl;
+        exit(0);
     }
-    double score = score1 + tradeoffCoefficient * score2;
-    return score;
+    return schedule;
+}
+
+void SessionOrganizer::readOrganization(string filename)
+{
+    conference->setSchedule(parseOrganization(filename, nullptr));
+}
+
+double SessionOrganizer::scoreErrorBound()
+{
+    // Number of distances each term of the score adds up.
+    double sessionPairs = (double)sessionsInTrack * parallelTracks * papersInSession * (papersInSession - 1) / 2;
+    double competingPairs = (double)sessionsInTrack * papersInSession * papersInSession * parallelTracks * (parallelTracks - 1) / 2;
+    return (sessionPairs + fabs(tradeoffCoefficient) * competingPairs) * distanceMatrix.max_error();
 }
@@ -15,9 +15,27 @@
 #include "Conference.h"
 #include "Track.h"
 #include "Session.h"
+#include "DistanceMatrix.h"
+#include "MatrixParser.h"
+#include "SearchBudget.h"
+#include "SimulatedAnnealing.h"
+#include "HillClimb.h"
 
 using namespace std;
 
+// Search algorithm used to organize the papers
+enum SearchEngine
+{
+    ENGINE_HILL_CLIMB,
+    ENGINE_ANNEALING,
+    ENGINE_TABU,
+    ENGINE_TEMPERING,
+    ENGINE_MEMETIC
+};
+
+// Reads a search engine by name (hillclimb, anneal, tabu, tempering or memetic), returns false for unknown names
+bool parse_search_engine(const char *name, SearchEngine &engine);
+
 /**
  * SessionOrganizer reads in a similarity matrix of papers, and organizes them
  * into sessions and tracks.
@@ -28,7 +46,8 @@ using namespace std;
 class SessionOrganizer
 {
   private:
-    double **distanceMatrix;
+    DistanceMatrix distanceMatrix;
+    MappedFile inputFile; // backs distanceMatrix when the input is binary
 
     int parallelTracks;
     int papersInSession;
@@ -39,28 +58,239 @@ class SessionOrganizer
     double processingTimeInMinutes;
     double tradeoffCoefficient; // the tradeoff coefficient
 
+    int threads; // number of search threads
+
+    MatrixFormat matrixFormat; // storage used for text inputs
+
+    SearchOptions searchOptions; // termination settings of the search
+
+    SearchEngine engine;
+    CoolingSchedule coolingSchedule; // used by ENGINE_ANNEALING
+    bool greedyInitialization;       // start searches from the greedy construction instead of a shuffle
+    int replicas;                    // used by ENGINE_TEMPERING, 0 picks a count from the threads
+    int islands;                     // used by ENGINE_MEMETIC, 0 picks a count from the threads
+
+    string warmStartFile;        // organization to re-optimize instead of searching from scratch, empty for none
+    vector<int> withdrawnPapers; // papers of warmStartFile that are no longer part of the conference
+    int maxMovedPapers;          // papers a warm start may move to another session, negative for no limit
+    SearchStats searchStats;     // counters of the last organizePapers
+
+    string *inputError; // receives what is wrong with a malformed input instead of ending the program, null to end it
+
+    /**
+     * Report a malformed input, ending the program unless the constructor
+     * was given somewhere to put the message. The reading function
+     * returns right after.
+     * @param message says what is wrong with the input.
+     */
+    void rejectInput(const string &message);
+
+    void readInBinaryFile();
+
+    /**
+     * Read the feature vectors of a text input whose sixth line is
+     * "embedding cosine|euclidean <dimensions>", one vector per line.
+     * @param lines are the lines of the input file.
+     */
+    void readInFeatures(const vector<const char *> &lines);
+
+    /**
+     * Read the neighbour lists of a text input whose sixth line is
+     * "neighbours <default distance>". Line i lists the papers near paper
+     * i as pairs of a paper and its distance; all other pairs are at the
+     * default distance. Every distance has to lie in [0, 1].
+     * @param lines are the lines of the input file.
+     */
+    void readInNeighbours(const vector<const char *> &lines);
+
+    /**
+     * Make the search continue from the checkpoint of the search options,
+     * if one was written.
+     * @param search is the hill climb about to run.
+     * @param workers is the number of threads it runs on.
+     */
+    void resumeSearch(HillClimb &search, int workers);
+
+    /**
+     * Create the search engine chosen by setEngine.
+     * @param threads is the number of threads the search may use.
+     * @param workers is set to the number of threads hill_climb has to run
+     * on, 1 for engines that spread their own work over the threads.
+     * @return the engine, owned by the caller.
+     */
+    HillClimb *createSearch(int threads, int &workers);
+
+    /**
+     * Parse an organization in the output format.
+     * @param filename is the name of the organization file.
+     * @param withdrawn are papers to leave out, null if every paper of the
+     * input has to appear exactly once. Otherwise the positions of these
+     * papers and of papers beyond the input are returned as -1.
+     * @return the schedule in the layout of Conference.
+     */
+    vector<int> parseOrganization(string filename, const vector<int> *withdrawn);
+
   public:
     SessionOrganizer();
-    SessionOrganizer(string filename);
+    /**
+     * Constructor, reads in the input file.
+     * @param filename is the name of the input file.
+     * @param threads is the number of threads used to parse and search.
+     * @param format is how the distances of a text input are stored.
+     * @param error receives what is wrong with a malformed input, which
+     * then leaves the organizer unusable, instead of the program ending.
+     * Null to end the program.
+     */
+    SessionOrganizer(string filename, int threads = 1, MatrixFormat format = MatrixFormat(), string *error = nullptr);
+
+    /**
+     * Constructor, shares the input another organizer read instead of
+     * reading a file, e.g. to try other settings on a cached input.
+     * @param input is the organizer that read the input, it has to outlive this one.
+     * @param threads is the number of threads used to search.
+     */
+    SessionOrganizer(const SessionOrganizer &input, int threads);
+
+    ~SessionOrganizer();
 
     /**
      * Read in the number of parallel tracks, papers in session, sessions
      * in a track, and the similarity matrix from the specified filename.
+     * Instead of the matrix the input may give a feature vector per paper,
+     * from which distances are computed when the search needs them, or
+     * the nearest neighbours of every paper.
      * @param filename is the name of the file containing the matrix.
      * @return the similarity matrix.
      */
     void readInInputFile(string filename);
 
+    /**
+     * Write the input parameters and the distance matrix in the binary
+     * format, which readInInputFile recognizes and maps without parsing.
+     * @param filename is the name of the binary file.
+     */
+    void writeBinaryFile(string filename);
+
+    /**
+     * Keep recently computed distance rows of an embedding input.
+     * @param rows is the number of rows kept, 0 for none.
+     */
+    void setRowCache(int rows);
+
     /**
      * Organize the papers according to some algorithm.
      */
     void organizePapers();
 
+    /**
+     * Search for an organization on the calling thread alone, leaving the
+     * current one untouched. Several of these searches may run at once,
+     * e.g. threads of a batch that join an instance at different times.
+     * @param seed seeds the search.
+     * @param minutes is the time budget of the search.
+     * @return the organization in the layout of Conference.
+     */
+    vector<int> searchOrganization(int seed, double minutes);
+
+    /**
+     * Get the current organization.
+     * @return the organization in the layout of Conference.
+     */
+    const vector<int> &getOrganization();
+
+    /**
+     * Replace the current organization.
+     * @param schedule is the organization in the layout of Conference.
+     */
+    void setOrganization(vector<int> schedule);
+
+    /**
+     * Get the time a search may take.
+     * @return the minutes of the processing time given to the search.
+     */
+    double getSearchTime();
+
+    /**
+     * Get the counters of the last organizePapers, e.g. the papers a warm
+     * start placed and moved.
+     * @return the counters merged over the search threads.
+     */
+    const SearchStats &getSearchStats();
+
+    /**
+     * Set the tradeoff coefficient, in place of the one of the input.
+     * @param tradeoffCoefficient weighs the distances between parallel sessions.
+     */
+    void setTradeoffCoefficient(double tradeoffCoefficient);
+
+    /**
+     * Set the processing time, in place of the one of the input.
+     * @param minutes is the time the organization may take.
+     */
+    void setProcessingTime(double minutes);
+
+    /**
+     * Get the shape of the conference.
+     * @return the number of parallel tracks, time slots and papers in a session.
+     */
+    int getParallelTracks();
+    int getSessionsInTrack();
+    int getPapersInSession();
+
+    /**
+     * Set the number of threads used by the search.
+     * @param threads is the number of worker threads.
+     */
+    void setThreads(int threads);
+
+    /**
+     * Set how the search terminates besides the time budget.
+     * @param options are the iteration budget, target score and clock checks.
+     */
+    void setSearchOptions(const SearchOptions &options);
+
+    /**
+     * Set the search algorithm.
+     * @param engine is the algorithm.
+     * @param coolingSchedule is the temperature schedule of simulated annealing.
+     */
+    void setEngine(SearchEngine engine, CoolingSchedule coolingSchedule = COOLING_GEOMETRIC);
+
+    /**
+     * Choose how searches build their starting organization.
+     * @param greedy starts from the greedy construction heuristic if true,
+     * from a random organization otherwise.
+     */
+    void setGreedyInitialization(bool greedy);
+
+    /**
+     * Set the number of replicas of parallel tempering.
+     * @param replicas is the number of temperatures, 0 picks one from the threads.
+     */
+    void setReplicas(int replicas);
+
+    /**
+     * Set the number of islands of the memetic search.
+     * @param islands is the number of populations, 0 picks one from the threads.
+     */
+    void setIslands(int islands);
+
+    /**
+     * Re-optimize an existing organization instead of searching from
+     * scratch. The withdrawn papers are taken out, the papers of the input
+     * that the organization lacks are placed in the freed positions, and
+     * only the sessions that changed are improved further.
+     * @param filename is the organization, empty to search from scratch.
+     * @param withdrawn are the papers of the organization to take out.
+     * @param maxMoved is the number of papers that may change session, negative for no limit.
+     */
+    void setWarmStart(string filename, const vector<int> &withdrawn, int maxMoved);
+
     /**
      * Get the distance matrix.
      * @return the distance matrix.
      */
-    double **getDistanceMatrix();
+    const DistanceMatrix &getDistanceMatrix();
 
     /**
      * Score the organization.
@@ -68,6 +298,27 @@ class SessionOrganizer
      */
     double scoreOrganization();
 
+    /**
+     * Score an organization other than the current one.
+     * @param schedule is the organization in the layout of Conference.
+     * @return the score.
+     */
+    double scoreOrganization(const vector<int> &schedule);
+
+    /**
+     * Read an organization in the output format, e.g. one written by an
+     * earlier run or by another tool, in place of the current one.
+     * @param filename is the name of the organization file.
+     */
+    void readOrganization(string filename);
+
+    /**
+     * Bound on how far any score can be from the exact score because of
+     * the precision the distances are stored in.
+     * @return the bound, 0 for exact storage.
+     */
+    double scoreErrorBound();
+
     void printSessionOrganiser(char *);
 };
 
@@ -0,0 +1,185 @@
+/* 
+ * File:   SimulatedAnnealing.cpp
+ * Author: Varun Srivastava
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "SimulatedAnnealing.h"
+
+constexpr double SimulatedAnnealing::INITIAL_ACCEPTANCE;
+constexpr double SimulatedAnnealing::FINAL_ACCEPTANCE;
+constexpr double SimulatedAnnealing::FINAL_RATIO;
+constexpr double SimulatedAnnealing::EXP_CUTOFF;
+constexpr double SimulatedAnnealing::REHEAT_FACTOR;
+
+bool parse_cooling_schedule(const char *name, CoolingSchedule &schedule)
+{
+    if (std::strcmp(name, "geometric") == 0)
+        schedule = COOLING_GEOMETRIC;
+    else if (std::strcmp(name, "adaptive") == 0)
+        schedule = COOLING_ADAPTIVE;
+    else if (std::strcmp(name, "reheat") == 0)
+        schedule = COOLING_REHEAT;
+    else
+        return false;
+    return true;
+}
+
+SimulatedAnnealing::SimulatedAnnealing(const DistanceMatrix &matrix, int p, int t, int k, double c, CoolingSchedule schedule)
+    : HillClimb(matrix, p, t, k, c), schedule(schedule), unit(0.0, 1.0)
+{
+}
+
+HillClimb *SimulatedAnnealing::clone() const
+{
+    return new SimulatedAnnealing(*this);
+}
+
+double SimulatedAnnealing::calibrate_temperature(const State &state)
+{
+    double worse = 0;
+    int count = 0;
+    for (int i = 0; i != CALIBRATION_SAMPLES; ++i)
+    {
+        auto pair = next_state();
+        double delta = score_increment(make_move(pair.first, pair.second, state));
+        if (delta < 0)
+        {
+            worse -= delta;
+            ++count;
+        }
+    }
+    if (count == 0)
+        return 1.0;
+    return -(worse / count) / std::log(INITIAL_ACCEPTANCE);
+}
+
+void SimulatedAnnealing::start(Walker &walker, bool random_init)
+{
+    if (random_init)
+        random_initialize(walker.state);
+    else
+        walker.state = greedy_initialize();
+    construct_session_matrix(walker.state);
+
+    walker.current = walker.best_score = score(walker.state);
+    walker.best_state = walker.state;
+    walker.saved = true;
+    walker.worse_tried = walker.worse_accepted = 0;
+}
+
+bool SimulatedAnnealing::step(Walker &walker, double temperature)
+{
+    bool whole_session = session_share(rng);
+    Move move;
+    SessionMove session_move;
+    if (whole_session)
+        session_move = next_session_move();
+    else
+    {
+        auto pair = next_state();
+        move = make_move(pair.first, pair.second, walker.state);
+    }
+    if (!whole_session && move.session_a == move.session_b)
+        return false;
+
+    bool active = false;
+    double delta = whole_session ? score_increment(session_move) : score_increment(move);
+    ++stats.evaluated;
+    if (delta < 0)
+    {
+        ++walker.worse_tried;
+        if (!accept(delta, temperature))
+            return false;
+        ++walker.worse_accepted;
+        ++stats.downhill;
+        active = true;
+        if (!walker.saved)
+        {
+            walker.best_state = walker.state;
+            walker.saved = true;
+        }
+    }
+    else
+        stats.accepted(delta);
+
+    if (whole_session)
+        update_state(session_move, walker.state);
+    else
+        update_state(move, walker.state);
+    walker.current += delta;
+    if (walker.current > walker.best_score)
+    {
+        walker.best_score = walker.current;
+        walker.saved = false;
+        active = true;
+    }
+    return active;
+}
+
+double SimulatedAnnealing::search(bool random_init, SearchBudget &budget, State &best_state)
+{
+    Walker walker;
+    start(walker, random_init);
+
+    const double initial = calibrate_temperature(walker.state);
+    double temperature = initial;
+
+    // The temperature changes once per epoch
+    const long long epoch = std::max(100, static_cast<int>(walker.state.size()));
+    long long moves = 0, last_activity = 0; // move of the last new best or accepted worsening move
+    double cycle_start = 0, cycle_peak = initial;
+
+    while (budget.next())
+    {
+        double best_score = walker.best_score;
+        if (step(walker, temperature))
+            last_activity = moves;
+        if (walker.best_score > best_score)
+        {
+            budget.report(walker.best_score);
+            if (budget.wants(walker.best_score))
+                budget.publish(walker.best_score, walker.state);
+        }
+
+        if (++moves % epoch)
+            continue;
+
+        double progress = budget.progress();
+        switch (schedule)
+        {
+        case COOLING_GEOMETRIC:
+            temperature = initial * std::pow(FINAL_RATIO, progress);
+            break;
+        case COOLING_ADAPTIVE:
+        {
+            // Only judge the rate once enough worsening moves were tried to expect a few acceptances
+            double target = INITIAL_ACCEPTANCE * std::pow(FINAL_ACCEPTANCE / INITIAL_ACCEPTANCE, progress);
+            if (walker.worse_tried * target < 10)
+                continue;
+            double rate = static_cast<double>(walker.worse_accepted) / walker.worse_tried;
+            temperature *= rate > target ? 0.9 : 1 / 0.9;
+            break;
+        }
+        case COOLING_REHEAT:
+            if (moves - last_activity > REHEAT_STALL * epoch && progress < 1)
+            {
+                // Frozen: start a new, shorter cycle from a few times the temperature it froze at
+                cycle_start = progress;
+                cycle_peak = std::min(initial, REHEAT_FACTOR * temperature);
+                last_activity = moves;
+            }
+            temperature = cycle_peak * std::pow(FINAL_RATIO, (progress - cycle_start) / std::max(1e-9, 1 - cycle_start));
+            break;
+        }
+        walker.worse_tried = walker.worse_accepted = 0;
+    }
+
+    finish(walker);
+    best_state = walker.best_state;
+    return walker.best_score;
+}
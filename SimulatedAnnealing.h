@@ -0,0 +1,87 @@
+/* 
+ * File:   SimulatedAnnealing.h
+ * Author: Varun Srivastava
+ *
+ */
+
+#ifndef SIMULATEDANNEALING_H
+#define SIMULATEDANNEALING_H
+
+#include <random>
+#include <cmath>
+
+#include "HillClimb.h"
+
+// How the temperature falls over the budget
+enum CoolingSchedule
+{
+  COOLING_GEOMETRIC, // exponential decay from the initial to the final temperature
+  COOLING_ADAPTIVE,  // steers the acceptance rate of worsening moves along a decaying target
+  COOLING_REHEAT     // geometric, reheated whenever the search freezes
+};
+
+// Reads a cooling schedule by name (geometric, adaptive or reheat), returns false for unknown names
+bool parse_cooling_schedule(const char *name, CoolingSchedule &schedule);
+
+/**
+ * Simulated annealing over the same swap neighbourhood and incremental
+ * evaluation as HillClimb. Each worker runs one annealing run over the
+ * whole budget, the initial temperature is calibrated from sampled
+ * score increments of the starting state.
+ */
+class SimulatedAnnealing : public HillClimb
+{
+private:
+  CoolingSchedule schedule;
+
+  // Metropolis test for a worsening move
+  bool accept(double delta, double temperature)
+  {
+    return delta > -EXP_CUTOFF * temperature && unit(rng) < std::exp(delta / temperature);
+  }
+
+protected:
+  std::uniform_real_distribution<double> unit;
+
+  // One annealing trajectory, the engine's aggregates describe its state
+  struct Walker
+  {
+    State state, best_state;
+    double current, best_score;
+    bool saved; // false while state is the best state but best_state is stale
+    long long worse_tried, worse_accepted;
+  };
+
+  // Builds the starting state of a walker and the aggregates for it
+  void start(Walker &, bool random_init);
+
+  // Proposes one move at the given temperature, true if it accepted a worsening move or reached a new best
+  bool step(Walker &, double temperature);
+
+  // Brings best_state of a finished walker up to date
+  void finish(Walker &walker)
+  {
+    if (!walker.saved)
+      walker.best_state = walker.state;
+    walker.saved = true;
+  }
+
+  // Temperature at which an average worsening move is accepted with probability INITIAL_ACCEPTANCE
+  double calibrate_temperature(const State &);
+
+  double search(bool, SearchBudget &, State &) override;
+  HillClimb *clone() const override;
+
+public:
+  static constexpr double INITIAL_ACCEPTANCE = 0.8;
+  static constexpr double FINAL_ACCEPTANCE = 1e-4;
+  static constexpr double FINAL_RATIO = 1e-2; // final over initial temperature
+  static constexpr double EXP_CUTOFF = 30;    // moves worse than this many temperatures are never accepted
+  static const int CALIBRATION_SAMPLES = 1000;
+  static const int REHEAT_STALL = 50;        // epochs without a new best or accepted worsening move before reheating
+  static constexpr double REHEAT_FACTOR = 4; // temperature increase of a reheat
+
+  SimulatedAnnealing(const DistanceMatrix &, int, int, int, double, CoolingSchedule);
+};
+
+#endif /* SIMULATEDANNEALING_H */
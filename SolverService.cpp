@@ -0,0 +1,499 @@
+/*
+ * File:   SolverService.cpp
+ * Author: Varun Srivastava
+ *
+ */
+
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "MatrixParser.h"
+#include "SessionOrganizer.h"
+#include "SolverService.h"
+
+// Longest request line accepted
+static const std::size_t MAX_REQUEST_BYTES = 1 << 20;
+
+// One client. Replies of its requests may be written by several threads.
+struct SolverService::Connection
+{
+    int fd;
+    std::mutex write_mutex;
+
+    explicit Connection(int fd) : fd(fd) {}
+    ~Connection() { close(fd); }
+
+    // Writes a line, a client that went away is not an error of the service
+    void send(const std::string &line)
+    {
+        std::lock_guard<std::mutex> lock(write_mutex);
+        std::string text = line + "\n";
+        for (std::size_t sent = 0; sent < text.size();)
+        {
+            ssize_t written = ::send(fd, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+            if (written < 0 && errno == EINTR)
+                continue;
+            if (written <= 0)
+                return;
+            sent += written;
+        }
+    }
+};
+
+/*
+ * Reads a JSON object of plain values. Strings are unescaped, numbers and
+ * literals are kept as written. Returns an empty string on success,
+ * otherwise what is wrong with the line.
+ */
+static std::string parse_request(const std::string &line, std::map<std::string, std::string> &fields)
+{
+    std::size_t at = 0;
+    auto skip_space = [&]() {
+        while (at < line.size() && std::isspace(static_cast<unsigned char>(line[at])))
+            ++at;
+    };
+    auto read_string = [&](std::string &out) {
+        if (at >= line.size() || line[at] != '"')
+            return false;
+        for (++at; at < line.size() && line[at] != '"'; ++at)
+        {
+            char c = line[at];
+            if (c == '\\')
+            {
+                if (++at == line.size())
+                    return false;
+                switch (line[at])
+                {
+                case 'n':
+                    c = '\n';
+                    break;
+                case 't':
+                    c = '\t';
+                    break;
+                case 'r':
+                    c = '\r';
+                    break;
+                case 'b':
+                    c = '\b';
+                    break;
+                case 'f':
+                    c = '\f';
+                    break;
+                case 'u':
+                    return false; // not needed for file names and settings
+                default:
+                    c = line[at];
+                }
+            }
+            out += c;
+        }
+        return at++ < line.size();
+    };
+
+    skip_space();
+    if (at >= line.size() || line[at++] != '{')
+        return "a request has to be a JSON object";
+    skip_space();
+    if (at < line.size() && line[at] == '}')
+        return "";
+    while (true)
+    {
+        std::string key, value;
+        skip_space();
+        if (!read_string(key))
+            return "malformed key";
+        skip_space();
+        if (at >= line.size() || line[at++] != ':')
+            return "missing ':' after \"" + key + "\"";
+        skip_space();
+        if (at < line.size() && line[at] == '"')
+        {
+            if (!read_string(value))
+                return "malformed string value of \"" + key + "\"";
+        }
+        else
+        {
+            std::size_t begin = at;
+            while (at < line.size() && line[at] != ',' && line[at] != '}' && !std::isspace(static_cast<unsigned char>(line[at])))
+                ++at;
+            value = line.substr(begin, at - begin);
+            if (value.empty() || value[0] == '{' || value[0] == '[')
+                return "\"" + key + "\" has to be a string, a number or a literal";
+        }
+        fields[key] = value;
+        skip_space();
+        if (at < line.size() && line[at] == ',')
+        {
+            ++at;
+            continue;
+        }
+        if (at < line.size() && line[at] == '}')
+            return "";
+        return "expected ',' or '}'";
+    }
+}
+
+static std::string json_string(const std::string &text)
+{
+    std::string out = "\"";
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        if (static_cast<unsigned char>(c) < 0x20)
+        {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+            continue;
+        }
+        out += c;
+    }
+    return out + "\"";
+}
+
+// Start of a reply to the request with the given id
+static std::string reply(const std::string &id, const char *event)
+{
+    return "{\"id\": " + json_string(id) + ", \"event\": \"" + event + "\"";
+}
+
+// Reply line with an organization as slots of tracks of papers
+static std::string organization_reply(const std::string &id, const char *event, double score, double seconds,
+                                      const std::vector<int> &schedule, int parallel_tracks, int papers_in_session)
+{
+    std::ostringstream out;
+    char numbers[96];
+    std::snprintf(numbers, sizeof(numbers), ", \"score\": %.6f, \"time\": %.3f, \"schedule\": [", score, seconds);
+    out << reply(id, event) << numbers;
+    const int papers_in_time_slot = parallel_tracks * papers_in_session;
+    for (std::size_t i = 0; i != schedule.size(); ++i)
+    {
+        if (i % papers_in_time_slot == 0)
+            out << (i ? "]], [[" : "[[");
+        else if (i % papers_in_session == 0)
+            out << "], [";
+        else
+            out << ", ";
+        out << schedule[i];
+    }
+    out << (schedule.empty() ? "]}" : "]]]}");
+    return out.str();
+}
+
+// FNV-1a of the bytes of an input file
+static std::uint64_t content_hash(const char *data, std::size_t size)
+{
+    std::uint64_t hash = 14695981039346656037ULL;
+    for (std::size_t i = 0; i != size; ++i)
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * 1099511628211ULL;
+    return hash;
+}
+
+SolverService::SolverService(const std::string &socket_path, int threads, int cache_size, int row_cache)
+    : socket_path(socket_path), threads(std::max(1, threads)), cache_size(std::max(1, cache_size)), row_cache(row_cache), listener(-1),
+      stopping(false),
+      running_requests(0), free_threads(this->threads), next_ticket(0), serving_ticket(0)
+{
+}
+
+SolverService::~SolverService()
+{
+    if (listener >= 0)
+    {
+        close(listener);
+        unlink(socket_path.c_str());
+    }
+}
+
+bool SolverService::run()
+{
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(address.sun_path))
+        return false;
+    std::strcpy(address.sun_path, socket_path.c_str());
+
+    listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0)
+        return false;
+    unlink(socket_path.c_str()); // left behind by a service that did not shut down
+    if (bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || listen(listener, 16) != 0)
+        return false;
+
+    while (!stopping)
+    {
+        int fd = accept(listener, nullptr, nullptr);
+        if (fd < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            break; // shut down by stop()
+        }
+        auto connection = std::make_shared<Connection>(fd);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            connections.insert(connection);
+        }
+        std::thread(&SolverService::serve, this, connection).detach();
+    }
+
+    // Answer the running requests, then hang up on clients that are still connected
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this]() { return running_requests == 0; });
+    for (const auto &connection : connections)
+        shutdown(connection->fd, SHUT_RD);
+    idle.wait(lock, [this]() { return connections.empty(); });
+    return true;
+}
+
+void SolverService::stop()
+{
+    stopping = true;
+    shutdown(listener, SHUT_RDWR); // wakes up accept
+}
+
+void SolverService::serve(std::shared_ptr<Connection> connection)
+{
+    std::string pending;
+    char buffer[1 << 16];
+    while (true)
+    {
+        ssize_t got = recv(connection->fd, buffer, sizeof(buffer), 0);
+        if (got < 0 && errno == EINTR)
+            continue;
+        if (got <= 0)
+            break;
+        pending.append(buffer, got);
+
+        std::size_t end;
+        while ((end = pending.find('\n')) != std::string::npos)
+        {
+            std::string line = pending.substr(0, end);
+            pending.erase(0, end + 1);
+            if (line.find_first_not_of(" \t\r") == std::string::npos)
+                continue;
+
+            std::map<std::string, std::string> request;
+            std::string error = parse_request(line, request);
+            const std::string id = request.count("id") ? request["id"] : "";
+            if (!error.empty())
+            {
+                connection->send(reply(id, "error") + ", \"message\": " + json_string(error) + "}");
+                continue;
+            }
+            if (request.count("shutdown") && request["shutdown"] == "true")
+            {
+                connection->send(reply(id, "shutdown") + "}");
+                stop();
+                continue;
+            }
+            if (stopping)
+            {
+                connection->send(reply(id, "error") + ", \"message\": \"the service is shutting down\"}");
+                continue;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ++running_requests;
+            }
+            std::thread(&SolverService::solve, this, connection, std::move(request)).detach();
+        }
+        if (pending.size() > MAX_REQUEST_BYTES)
+        {
+            connection->send(reply("", "error") + ", \"message\": \"request line too long\"}");
+            break;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    connections.erase(connection);
+    idle.notify_all();
+}
+
+std::shared_ptr<SessionOrganizer> SolverService::load(const std::string &filename, int threads, bool &cached, std::string &error)
+{
+    MappedFile file;
+    if (!file.open(filename))
+    {
+        error = "unable to open input file " + filename;
+        return nullptr;
+    }
+    const std::uint64_t hash = content_hash(file.begin(), file.size());
+    file.close();
+
+    auto find = [&]() -> std::shared_ptr<SessionOrganizer> {
+        for (auto entry = cache.begin(); entry != cache.end(); ++entry)
+            if (entry->hash == hash)
+            {
+                cache.splice(cache.begin(), cache, entry);
+                return cache.front().input;
+            }
+        return nullptr;
+    };
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        if (auto input = find())
+        {
+            cached = true;
+            return input;
+        }
+    }
+
+    // Read without holding the cache, so requests for cached inputs are not held up.
+    // A malformed input is answered with what is wrong instead of ending the service.
+    std::shared_ptr<SessionOrganizer> input = std::make_shared<SessionOrganizer>(filename, threads, MatrixFormat(), &error);
+    if (!error.empty())
+        return nullptr;
+    input->setRowCache(row_cache); // shared by the organizers of every request on this input
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    cached = false;
+    if (auto other = find())
+        return other; // read by a concurrent request in the meantime
+    cache.push_front(CachedInput{hash, input});
+    if (cache.size() > cache_size)
+        cache.pop_back(); // requests still using it keep it alive
+    return input;
+}
+
+/*
+ * Waits for the turn of the request and for a free thread, then takes an
+ * equal share of the free threads with the requests waiting behind it.
+ */
+int SolverService::acquire_threads()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    const long long ticket = next_ticket++;
+    threads_freed.wait(lock, [&]() { return ticket == serving_ticket && free_threads > 0; });
+    const int share = std::max(1, free_threads / static_cast<int>(next_ticket - ticket));
+    free_threads -= share;
+    ++serving_ticket;
+    threads_freed.notify_all(); // the next request may take what is left
+    return share;
+}
+
+void SolverService::release_threads(int share)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    free_threads += share;
+    threads_freed.notify_all();
+}
+
+void SolverService::solve(std::shared_ptr<Connection> connection, std::map<std::string, std::string> request)
+{
+    const auto start = Time::now();
+    const std::string id = request.count("id") ? request["id"] : "";
+    auto seconds = [&]() { return std::chrono::duration_cast<double_seconds>(Time::now() - start).count(); };
+    auto done = [&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        --running_requests;
+        idle.notify_all();
+    };
+
+    std::string error;
+    SearchEngine engine = ENGINE_HILL_CLIMB;
+    CoolingSchedule cooling = COOLING_GEOMETRIC;
+    if (!request.count("input"))
+        error = "missing \"input\"";
+    else if (request.count("engine") && !parse_search_engine(request["engine"].c_str(), engine))
+        error = "unknown engine " + request["engine"];
+    else if (request.count("cooling") && !parse_cooling_schedule(request["cooling"].c_str(), cooling))
+        error = "unknown cooling schedule " + request["cooling"];
+    else if (request.count("minutes") && !(std::atof(request["minutes"].c_str()) > 0))
+        error = "\"minutes\" has to be positive";
+    else if (request.count("init") && request["init"] != "random" && request["init"] != "greedy")
+        error = "unknown init " + request["init"];
+    bool cached = false;
+    std::shared_ptr<SessionOrganizer> input;
+    int share = 0;
+    if (error.empty())
+    {
+        share = acquire_threads();
+        input = load(request["input"], share, cached, error);
+    }
+    if (!input)
+    {
+        if (share)
+            release_threads(share);
+        connection->send(reply(id, "error") + ", \"message\": " + json_string(error) + "}");
+        done();
+        return;
+    }
+
+    SessionOrganizer organizer(*input, share);
+    organizer.setEngine(engine, cooling);
+    organizer.setGreedyInitialization(request.count("init") && request["init"] == "greedy");
+    if (request.count("tradeoff"))
+        organizer.setTradeoffCoefficient(std::atof(request["tradeoff"].c_str()));
+    if (request.count("minutes"))
+        organizer.setProcessingTime(std::atof(request["minutes"].c_str()));
+
+    const int parallel_tracks = organizer.getParallelTracks();
+    const int papers_in_session = organizer.getPapersInSession();
+    SearchOptions options;
+    if (request.count("iterations"))
+        options.max_iterations = std::atoll(request["iterations"].c_str());
+
+    // The search only records an improvement, a writer thread sends it so a slow client
+    // does not hold up the search. Only the latest improvement waits to be sent.
+    std::mutex best_mutex;
+    std::condition_variable improved;
+    double best = std::numeric_limits<double>::lowest();
+    double best_seconds = 0;
+    std::vector<int> best_state;
+    bool unsent = false, searching = true;
+    options.on_improvement = [&](double score, const std::vector<int> &state) {
+        std::lock_guard<std::mutex> lock(best_mutex);
+        if (score <= best)
+            return; // another worker of the request got further
+        best = score;
+        best_seconds = seconds();
+        best_state = state;
+        unsent = true;
+        improved.notify_one();
+    };
+    std::thread writer([&]() {
+        std::unique_lock<std::mutex> lock(best_mutex);
+        while (true)
+        {
+            improved.wait(lock, [&]() { return unsent || !searching; });
+            if (!unsent)
+                return;
+            unsent = false;
+            const double score = best, at = best_seconds;
+            std::vector<int> state;
+            state.swap(best_state);
+            lock.unlock();
+            connection->send(organization_reply(id, "improved", score, at, state, parallel_tracks, papers_in_session));
+            lock.lock();
+        }
+    });
+    organizer.setSearchOptions(options);
+    organizer.organizePapers();
+    release_threads(share);
+    {
+        std::lock_guard<std::mutex> lock(best_mutex);
+        searching = false;
+    }
+    improved.notify_one();
+    writer.join(); // the last improvement is sent before the answer
+
+    std::string line = organization_reply(id, "done", organizer.scoreOrganization(), seconds(), organizer.getOrganization(),
+                                          parallel_tracks, papers_in_session);
+    line.insert(line.size() - 1, std::string(", \"cached\": ") + (cached ? "true" : "false") + ", \"threads\": " + std::to_string(share));
+    connection->send(line);
+    done();
+}
@@ -0,0 +1,94 @@
+/*
+ * File:   SolverService.h
+ * Author: Varun Srivastava
+ *
+ */
+
+#ifndef SOLVERSERVICE_H
+#define SOLVERSERVICE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+
+class SessionOrganizer;
+
+/**
+ * SolverService answers solve requests on a Unix domain socket, for
+ * interactive planning where reading the input again for every run would
+ * dominate. Inputs are kept in memory keyed by a hash of their content, so
+ * an edited file is read again while the same content under another name
+ * is not.
+ *
+ * Requests and replies are JSON objects, one per line. A request names an
+ * input and optionally overrides its settings:
+ *
+ *   {"id": "a", "input": "conf.txt", "minutes": 0.1, "tradeoff": 2,
+ *    "engine": "anneal", "cooling": "adaptive", "init": "greedy", "iterations": 100000}
+ *
+ * While the search runs, improving organizations are streamed back as
+ * {"id": "a", "event": "improved", ...} lines, followed by a final
+ * "done" or an "error" line. {"shutdown": true} stops the service once
+ * the running requests are answered. Requests of all connections run at
+ * the same time on the service threads: a request takes an equal share of
+ * the free threads with the requests waiting behind it, and gives them back
+ * when it is answered. Requests wait in order of arrival while no thread
+ * is free, so the searches never use more threads than the service has.
+ */
+class SolverService
+{
+private:
+  struct Connection;
+  struct CachedInput
+  {
+    std::uint64_t hash;
+    std::shared_ptr<SessionOrganizer> input;
+  };
+
+  std::string socket_path;
+  int threads;
+  std::size_t cache_size;
+  int row_cache; // computed distance rows kept per embedding input
+  int listener;
+  std::atomic<bool> stopping;
+
+  std::mutex cache_mutex;
+  std::list<CachedInput> cache; // most recently used first
+
+  std::mutex mutex;
+  std::condition_variable idle;
+  int running_requests;
+  std::condition_variable threads_freed;
+  int free_threads;         // service threads no request holds
+  long long next_ticket;    // handed to the next request that asks for threads
+  long long serving_ticket; // request whose turn it is to take threads
+  std::set<std::shared_ptr<Connection>> connections;
+
+  void serve(std::shared_ptr<Connection> connection);
+  void solve(std::shared_ptr<Connection> connection, std::map<std::string, std::string> request);
+  std::shared_ptr<SessionOrganizer> load(const std::string &filename, int threads, bool &cached, std::string &error);
+  int acquire_threads();
+  void release_threads(int share);
+  void stop();
+
+public:
+  SolverService(const std::string &socket_path, int threads, int cache_size, int row_cache = 0);
+  ~SolverService();
+
+  SolverService(const SolverService &) = delete;
+  SolverService &operator=(const SolverService &) = delete;
+
+  // Serves until a shutdown request, returns false if the socket cannot be opened
+  bool run();
+
+  // Inputs kept in memory by default
+  static const int DEFAULT_CACHE_SIZE = 8;
+};
+
+#endif /* SOLVERSERVICE_H */
@@ -0,0 +1,144 @@
+/* 
+ * File:   TabuSearch.cpp
+ * Author: Varun Srivastava
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "TabuSearch.h"
+#include "WorkerPool.h"
+
+TabuSearch::TabuSearch(const DistanceMatrix &matrix, int p, int t, int k, double c, int scan_threads)
+    : HillClimb(matrix, p, t, k, c), scan_threads(std::max(1, scan_threads))
+{
+}
+
+HillClimb *TabuSearch::clone() const
+{
+    return new TabuSearch(*this);
+}
+
+bool TabuSearch::is_tabu(const Move &move, long long step) const
+{
+    return (left_session[move.paper_a] == move.session_b && tabu_until[move.paper_a] > step) ||
+           (left_session[move.paper_b] == move.session_a && tabu_until[move.paper_b] > step);
+}
+
+double TabuSearch::search(bool random_init, SearchBudget &budget, State &best_state)
+{
+    const int n = parallel_tracks * sessions_in_track * papers_in_session;
+    State state;
+    if (random_init)
+        random_initialize(state);
+    else
+        state = greedy_initialize();
+    construct_session_matrix(state);
+
+    double current = score(state);
+    double best_score = current;
+    best_state = state;
+
+    left_session.assign(n, -1);
+    tabu_until.assign(n, 0);
+    const int tenure = std::max(7, static_cast<int>(std::sqrt(static_cast<double>(n))));
+
+    const long long pairs = static_cast<long long>(n) * (n - 1) / 2;
+    const bool full_scan = pairs <= FULL_SCAN_LIMIT;
+
+    WorkerPool pool(scan_threads);
+    const int workers = pool.size();
+    vector<Move> best_moves(workers);
+    vector<double> best_deltas(workers);
+    vector<long long> evaluated(workers);
+    vector<std::default_random_engine> engines(workers);
+
+    // The budget is charged with the swaps a step evaluated, so iteration limits count moves as in the other engines
+    long long step = 0, last_improvement = 0, scanned = 0;
+    while (budget.next(scanned))
+    {
+        for (int w = 0; w != workers; ++w)
+            engines[w].seed(rng());
+
+        // Each worker finds the best admissible swap of its share of the neighbourhood
+        pool.run([&](int w) {
+            double found = std::numeric_limits<double>::lowest();
+            Move chosen = Move();
+            long long count = 0;
+            auto consider = [&](int i, int j) {
+                Move move = make_move(i, j, state);
+                if (move.session_a == move.session_b)
+                    return;
+                ++count;
+                double delta = score_increment(move);
+                if (delta > found && (current + delta > best_score || !is_tabu(move, step)))
+                {
+                    found = delta;
+                    chosen = move;
+                }
+            };
+            if (full_scan)
+            {
+                // Rows are dealt out round robin so the triangle splits evenly
+                for (int i = w; i < n; i += workers)
+                    for (int j = (i / papers_in_session + 1) * papers_in_session; j < n; ++j)
+                        consider(i, j);
+            }
+            else
+            {
+                std::uniform_int_distribution<int> position(0, n - 1);
+                for (long long s = w; s < FULL_SCAN_LIMIT; s += workers)
+                    consider(position(engines[w]), position(engines[w]));
+            }
+            best_deltas[w] = found;
+            best_moves[w] = chosen;
+            evaluated[w] = count;
+        });
+        scanned = 0;
+        for (int w = 0; w != workers; ++w)
+            scanned += evaluated[w];
+        stats.evaluated += scanned;
+
+        int pick = 0;
+        for (int w = 1; w != workers; ++w)
+            if (best_deltas[w] > best_deltas[pick])
+                pick = w;
+        if (best_deltas[pick] == std::numeric_limits<double>::lowest())
+            break; // everything is tabu, nothing left to do
+
+        stats.accepted(best_deltas[pick]);
+        const Move &move = best_moves[pick];
+        update_state(move, state);
+        current += best_deltas[pick];
+        left_session[move.paper_a] = move.session_a;
+        left_session[move.paper_b] = move.session_b;
+        tabu_until[move.paper_a] = tabu_until[move.paper_b] = step + tenure + rng() % (tenure / 2 + 1);
+
+        if (current > best_score)
+        {
+            best_score = current;
+            best_state = state;
+            last_improvement = step;
+            budget.report(best_score);
+            if (budget.wants(best_score))
+                budget.publish(best_score, state);
+        }
+        else if (step - last_improvement > STALL_STEPS)
+        {
+            // Kick the search somewhere else with as many random swaps as there are sessions
+            ++stats.restarts;
+            for (int s = 0; s != parallel_tracks * sessions_in_track; ++s)
+            {
+                auto pair = next_state();
+                Move kick = make_move(pair.first, pair.second, state);
+                current += score_increment(kick);
+                update_state(kick, state);
+            }
+            last_improvement = step;
+        }
+        ++step;
+    }
+    return best_score;
+}
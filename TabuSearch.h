@@ -0,0 +1,42 @@
+/* 
+ * File:   TabuSearch.h
+ * Author: Varun Srivastava
+ *
+ */
+
+#ifndef TABUSEARCH_H
+#define TABUSEARCH_H
+
+#include "HillClimb.h"
+
+/**
+ * Tabu search over the swap neighbourhood. Every step evaluates the whole
+ * neighbourhood, or a random candidate list of it on large instances, with
+ * score_increment, split over a pool of scan threads, and applies the best
+ * admissible swap with update_state. A paper may not return to the session
+ * it just left for a tenure number of steps unless that yields a new best
+ * score (aspiration). Long stalls are broken by a random perturbation.
+ */
+class TabuSearch : public HillClimb
+{
+private:
+  int scan_threads;
+
+  // Session each paper last left and the step until which it may not return there
+  vector<int> left_session;
+  vector<long long> tabu_until;
+
+  bool is_tabu(const Move &, long long step) const;
+
+protected:
+  double search(bool, SearchBudget &, State &) override;
+  HillClimb *clone() const override;
+
+public:
+  static const long long FULL_SCAN_LIMIT = 1 << 20; // largest neighbourhood scanned completely, larger ones are sampled
+  static const int STALL_STEPS = 1000;              // steps without a new best before perturbing
+
+  TabuSearch(const DistanceMatrix &, int, int, int, double, int scan_threads);
+};
+
+#endif /* TABUSEARCH_H */
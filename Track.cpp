@@ -8,18 +8,19 @@
 
 #include "Track.h"
 
-Track::Track(int sessionsInTrack)
+Track::Track(int *papers, int sessionsInTrack, int papersInSession, int sessionStride)
 {
+    this->papers = papers;
     this->sessionsInTrack = sessionsInTrack;
-    sessions = (Session *)malloc(sizeof(Session) * sessionsInTrack);
+    this->papersInSession = papersInSession;
+    this->sessionStride = sessionStride;
 }
 
 void Track::setPaper(int sessionIndex, int paperIndex, int paperId)
 {
     if (sessionIndex < this->sessionsInTrack)
     {
-        Session curSession = sessions[sessionIndex];
-        curSession.setPaper(paperIndex, paperId);
+        getSession(sessionIndex).setPaper(paperIndex, paperId);
     }
     else
     {
@@ -28,29 +29,15 @@ void Track::setPaper(int sessionIndex, int paperIndex, int paperId)
     }
 }
 
-int Track::getNumberOfSessions()
+void Track::setSession(int index, const Session &session)
 {
-    return this->sessionsInTrack;
-}
-
-Session Track::getSession(int index)
-{
-    if (index < this->sessionsInTrack)
-    {
-        return sessions[index];
-    }
-    else
-    {
-        cout << "Index out of bound - Track::getSession" << endl;
-        exit(0);
-    }
-}
-
-void Track::setSession(int index, Session session)
-{
-    if (index < this->sessionsInTrack)
+    if (index < this->sessionsInTrack && session.getNumberOfPapers() == papersInSession)
     {
-        sessions[index] = session;
+        Session target = getSession(index);
+        for (int k = 0; k < papersInSession; k++)
+        {
+            target.setPaper(k, session.getPaper(k));
+        }
     }
     else
     {
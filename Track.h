@@ -11,7 +11,9 @@
 #include "Session.h"
 
 /**
- * Track maintains an array of sessions.
+ * Track is a view of the sessions of one track inside the schedule stored
+ * by Conference. Consecutive sessions of a track lie sessionStride papers
+ * apart, one time slot of all tracks further.
  * 
  * @author Kapil Thakkar
  *
@@ -20,17 +22,23 @@
 class Track
 {
 private:
-  Session *sessions;
+  int *papers; // first paper of the first session
   int sessionsInTrack;
+  int papersInSession;
+  int sessionStride;
 
 public:
   Track() = delete;
 
   /**
-     * Constructor : Creates Track with given number of Sessions
+     * Constructor : view of the given number of sessions
      * 
+     * @param papers is the first paper of the first session.
+     * @param sessionsInTrack is the number of sessions.
+     * @param papersInSession is the number of papers in a session.
+     * @param sessionStride is the distance between the first papers of consecutive sessions.
      */
-  Track(int sessionsInTrack);
+  Track(int *papers, int sessionsInTrack, int papersInSession, int sessionStride);
 
   /**
      * Set the paper at the slot index to the specified paper id number.
@@ -46,23 +54,31 @@ public:
      * 
      * @return the number of sessions in the track.
      */
-  int getNumberOfSessions();
+  int getNumberOfSessions() const { return sessionsInTrack; }
 
   /**
      * Get a specified session.
      * 
      * @param index is the index of the session in question.
-     * @return the session at the index.
+     * @return a view of the session at the index.
      */
-  Session getSession(int index);
+  Session getSession(int index) const
+  {
+    if (index >= sessionsInTrack)
+    {
+      cout << "Index out of bound - Track::getSession" << endl;
+      exit(0);
+    }
+    return Session(papers + static_cast<size_t>(index) * sessionStride, papersInSession);
+  }
 
   /**
-     * Set the session at the specified index to the new session.
+     * Copy the papers of a session into the session at the specified index.
      * 
      * @param index is the index of the session.
-     * @param session is the new session
+     * @param session is the session to copy.
      */
-  void setSession(int index, Session session);
+  void setSession(int index, const Session &session);
 };
 
 #endif /* TRACK_H */
@@ -0,0 +1,65 @@
+/* 
+ * File:   WorkerPool.cpp
+ * Author: Varun Srivastava
+ *
+ */
+
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool(int size) : round(0), pending(0), stopping(false)
+{
+    for (int w = 1; w < size; ++w)
+        threads.emplace_back(&WorkerPool::work, this, w);
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto &t : threads)
+        t.join();
+}
+
+void WorkerPool::work(int worker)
+{
+    long long seen = 0;
+    while (true)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [&]() { return stopping || round != seen; });
+        if (stopping)
+            return;
+        seen = round;
+        lock.unlock();
+
+        task(worker);
+
+        lock.lock();
+        if (--pending == 0)
+            finished.notify_one();
+    }
+}
+
+void WorkerPool::run(const std::function<void(int)> &task)
+{
+    if (threads.empty())
+    {
+        task(0);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->task = task;
+        pending = threads.size();
+        ++round;
+    }
+    wake.notify_all();
+
+    task(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [&]() { return pending == 0; });
+}
@@ -0,0 +1,49 @@
+/* 
+ * File:   WorkerPool.h
+ * Author: Varun Srivastava
+ *
+ */
+
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * WorkerPool keeps threads alive between rounds of work, for searches that
+ * split every step (e.g. a neighbourhood scan) over several cores and
+ * cannot afford to start threads each time. The calling thread takes part
+ * as worker 0.
+ */
+class WorkerPool
+{
+private:
+  std::vector<std::thread> threads;
+  std::mutex mutex;
+  std::condition_variable wake, finished;
+  std::function<void(int)> task;
+  long long round;
+  int pending;
+  bool stopping;
+
+  void work(int worker);
+
+public:
+  explicit WorkerPool(int size);
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool &operator=(const WorkerPool &) = delete;
+
+  // Number of workers including the caller
+  int size() const { return threads.size() + 1; }
+
+  // Runs task(w) for every worker w and returns once all of them are done
+  void run(const std::function<void(int)> &task);
+};
+
+#endif /* WORKERPOOL_H */
@@ -0,0 +1,288 @@
+/*
+ * File:   batch.cpp
+ * Author: Varun Srivastava
+ *
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "SessionOrganizer.h"
+
+using namespace std;
+
+/*
+ * One instance of the manifest. Several threads may search it at once,
+ * each with a seed of its own, and the best organization is kept.
+ */
+struct Job
+{
+    string input, output;
+    unique_ptr<SessionOrganizer> organizer;
+    int n = 0;
+
+    Time::time_point deadline; // shared by every thread that searches the job
+    bool started = false, finished = false;
+    int active = 0;  // threads searching it now
+    int threads = 0; // threads that have searched it
+
+    vector<int> best;
+    double bestScore = numeric_limits<double>::lowest();
+    int bestSeed = 0;
+};
+
+// A thread only joins a running job if this much of its budget is left
+static const double MIN_JOIN_SECONDS = 0.5;
+
+static const int ANSWER_TO_THE_UNIVERSE = 43;
+
+/*
+ * Reads the input and output file of every job, one pair per line. Blank
+ * lines and lines starting with '#' are skipped.
+ */
+static vector<Job> readManifest(const string &filename)
+{
+    ifstream in(filename.c_str());
+    if (!in)
+    {
+        cout << "Unable to read manifest " << filename << endl;
+        exit(0);
+    }
+    vector<Job> jobs;
+    string line;
+    for (int number = 1; getline(in, line); ++number)
+    {
+        istringstream fields(line);
+        string input, output, extra;
+        if (!(fields >> input) || input[0] == '#')
+            continue;
+        if (!(fields >> output) || fields >> extra)
+        {
+            cout << "Manifest line " << number << " needs an input and an output file" << endl;
+            exit(0);
+        }
+        jobs.push_back(Job());
+        jobs.back().input = input;
+        jobs.back().output = output;
+    }
+    return jobs;
+}
+
+/*
+ * Hands out the jobs to the threads of the batch. Jobs start largest first,
+ * one thread each, so that as many run side by side as there are threads.
+ * Once every job has started, a thread that becomes free joins the running
+ * job with the most papers per searching thread, which splits the threads
+ * among the last jobs in proportion to their size.
+ */
+class Scheduler
+{
+  private:
+    vector<Job> &jobs;
+    bool joinRunning; // false when searches count moves instead of time
+    size_t nextJob;
+    mutex lock;
+
+  public:
+    Scheduler(vector<Job> &jobs, bool joinRunning) : jobs(jobs), joinRunning(joinRunning), nextJob(0) {}
+
+    /**
+     * Pick the job a free thread works on next.
+     * @param seed is set to the seed of the thread's search.
+     * @param minutes is set to the time it has left.
+     * @return the job, null when nothing is left to do.
+     */
+    Job *take(int &seed, double &minutes)
+    {
+        lock_guard<mutex> guard(lock);
+        Time::time_point now = Time::now();
+        Job *job = nullptr;
+        if (nextJob != jobs.size())
+        {
+            job = &jobs[nextJob++];
+            job->started = true;
+            minutes = job->organizer->getSearchTime();
+            job->deadline = now + chrono::duration_cast<Time::duration>(double_seconds(minutes * 60));
+        }
+        else if (joinRunning)
+        {
+            for (Job &running : jobs)
+            {
+                double left = chrono::duration_cast<double_seconds>(running.deadline - now).count();
+                if (running.finished || running.active == 0 || left < MIN_JOIN_SECONDS)
+                    continue;
+                if (!job || (double)running.n / running.active > (double)job->n / job->active)
+                    job = &running;
+            }
+            if (job)
+                minutes = chrono::duration_cast<double_seconds>(job->deadline - now).count() / 60;
+        }
+        if (job)
+        {
+            seed = ANSWER_TO_THE_UNIVERSE + job->threads++;
+            job->active++;
+        }
+        return job;
+    }
+
+    /**
+     * Hand in the organization a thread found.
+     * @return true if it was the last thread searching the job, which is then finished.
+     */
+    bool finish(Job &job, vector<int> &schedule, double score, int seed)
+    {
+        lock_guard<mutex> guard(lock);
+        // Ties go to the lowest seed so the result does not depend on which thread finished first
+        if (score > job.bestScore || (score == job.bestScore && seed < job.bestSeed))
+        {
+            job.best.swap(schedule);
+            job.bestScore = score;
+            job.bestSeed = seed;
+        }
+        job.finished = --job.active == 0;
+        return job.finished;
+    }
+
+    /**
+     * Print a line without interleaving it with other threads.
+     */
+    void report(const string &line)
+    {
+        lock_guard<mutex> guard(lock);
+        cout << line << endl;
+    }
+};
+
+/*
+ * Organizes every instance of a manifest in one process. The inputs are
+ * read by all threads at once, then the threads search the instances, each
+ * for the processing time given in its input file, and every organization
+ * is written as soon as its last search ends.
+ */
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        cout << "Missing arguments\n";
+        cout << "Correct format : \n";
+        cout << "./batch <manifest> [--threads N] [--precision double|float|fixed16] [--triangle]"
+             << " [--iterations N] [--fixed-iterations N] [--engine hillclimb|anneal|tabu|tempering|memetic]"
+             << " [--cooling geometric|adaptive|reheat] [--init random|greedy] [--row-cache N]";
+        exit(0);
+    }
+
+    int threads = max(1u, thread::hardware_concurrency());
+    MatrixFormat format;
+    SearchOptions options;
+    SearchEngine engine = ENGINE_HILL_CLIMB;
+    CoolingSchedule cooling = COOLING_GEOMETRIC;
+    bool greedy = false;
+    int rowCache = 0;
+    for (int i = 2; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            threads = max(1, atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--precision") == 0 && i + 1 < argc && parse_element_type(argv[i + 1], format.element))
+        {
+            i++;
+        }
+        else if (strcmp(argv[i], "--triangle") == 0)
+        {
+            format.layout = LAYOUT_UPPER_TRIANGLE;
+        }
+        else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+        {
+            options.max_iterations = atoll(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--fixed-iterations") == 0 && i + 1 < argc)
+        {
+            options.max_iterations = atoll(argv[++i]);
+            options.fixed_iterations = true;
+        }
+        else if (strcmp(argv[i], "--engine") == 0 && i + 1 < argc && parse_search_engine(argv[i + 1], engine))
+        {
+            i++;
+        }
+        else if (strcmp(argv[i], "--cooling") == 0 && i + 1 < argc && parse_cooling_schedule(argv[i + 1], cooling))
+        {
+            i++;
+        }
+        else if (strcmp(argv[i], "--init") == 0 && i + 1 < argc && (strcmp(argv[i + 1], "random") == 0 || strcmp(argv[i + 1], "greedy") == 0))
+        {
+            greedy = strcmp(argv[++i], "greedy") == 0;
+        }
+        else if (strcmp(argv[i], "--row-cache") == 0 && i + 1 < argc)
+        {
+            rowCache = atoi(argv[++i]);
+        }
+        else
+        {
+            cout << "Unknown argument " << argv[i] << endl;
+            exit(0);
+        }
+    }
+
+    vector<Job> jobs = readManifest(argv[1]);
+
+    // Every thread reads whole inputs, text or binary, until none are left
+    atomic<size_t> nextInput(0);
+    auto load = [&]() {
+        for (size_t j; (j = nextInput++) < jobs.size();)
+        {
+            Job &job = jobs[j];
+            job.organizer.reset(new SessionOrganizer(job.input, 1, format));
+            job.organizer->setRowCache(rowCache); // shared by every thread that searches the job
+            job.organizer->setSearchOptions(options);
+            job.organizer->setEngine(engine, cooling);
+            job.organizer->setGreedyInitialization(greedy);
+            job.n = job.organizer->getDistanceMatrix().size();
+        }
+    };
+    vector<thread> pool;
+    for (int w = 1; w < threads; ++w)
+        pool.emplace_back(load);
+    load();
+    for (thread &t : pool)
+        t.join();
+    pool.clear();
+
+    stable_sort(jobs.begin(), jobs.end(), [](const Job &a, const Job &b) { return a.n > b.n; });
+
+    Scheduler scheduler(jobs, !options.fixed_iterations);
+    auto work = [&]() {
+        int seed;
+        double minutes;
+        while (Job *job = scheduler.take(seed, minutes))
+        {
+            vector<int> schedule = job->organizer->searchOrganization(seed, minutes);
+            double score = job->organizer->scoreOrganization(schedule);
+            if (!scheduler.finish(*job, schedule, score, seed))
+                continue;
+            job->organizer->setOrganization(job->best);
+            job->organizer->printSessionOrganiser(&job->output[0]);
+            char line[64];
+            snprintf(line, sizeof(line), ": score %.6f, %d threads", job->bestScore, job->threads);
+            scheduler.report(job->output + line);
+        }
+    };
+    for (int w = 1; w < threads; ++w)
+        pool.emplace_back(work);
+    work();
+    for (thread &t : pool)
+        t.join();
+
+    return 0;
+}
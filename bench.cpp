@@ -0,0 +1,351 @@
+/*
+ * File:   bench.cpp
+ * Author: Varun Srivastava
+ *
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "HillClimb.h"
+#include "Kernels.h"
+#include "SearchBudget.h"
+
+using namespace std;
+
+/*
+ * Heap allocations made by the whole program, to check that the search
+ * kernels run without allocating.
+ */
+static atomic<long long> allocations(0);
+
+void *operator new(size_t size)
+{
+    ++allocations;
+    if (void *p = malloc(size ? size : 1))
+        return p;
+    throw bad_alloc();
+}
+
+// Out of line so that the compiler does not match the free against an inlined new
+__attribute__((noinline)) void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+__attribute__((noinline)) void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+/*
+ * Exposes the protected parts of HillClimb the benchmark times.
+ */
+class BenchClimb : public HillClimb
+{
+  public:
+    using HillClimb::HillClimb;
+    using HillClimb::construct_session_matrix;
+    using HillClimb::random_initialize;
+    using HillClimb::score;
+};
+
+/*
+ * Timing of one kernel at one problem shape.
+ */
+struct Result
+{
+    int n, k, p, t;
+    string kernel;
+    long long batch; // calls per repetition
+    double median_ns, p99_ns; // per call
+    double allocations_per_call;
+};
+
+/*
+ * Distance of a pair, a hash of the pair so that the matrix is symmetric
+ * and the same for every run.
+ */
+static double pairDistance(int i, int j)
+{
+    uint64_t x = static_cast<uint64_t>(min(i, j)) << 32 | static_cast<uint64_t>(max(i, j));
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return i == j ? 0 : (x >> 11) * (1.0 / (1ULL << 53));
+}
+
+static DistanceMatrix randomMatrix(int n, MatrixFormat format)
+{
+    DistanceMatrix matrix(n, format);
+    vector<double> values(n);
+    for (int i = 0; i != n; ++i)
+    {
+        for (int j = 0; j != n; ++j)
+            values[j] = pairDistance(i, j);
+        matrix.set_row(i, values.data());
+    }
+    return matrix;
+}
+
+/*
+ * Times warmup + reps repetitions of run, which makes batch calls, and
+ * reports the median and 99th percentile time per call.
+ */
+template <typename Run>
+static Result measure(const string &kernel, long long batch, int warmup, int reps, Run run)
+{
+    vector<double> samples;
+    long long allocated = 0;
+    for (int r = 0; r != warmup + reps; ++r)
+    {
+        long long before = allocations;
+        auto start = Time::now();
+        run();
+        double elapsed = chrono::duration_cast<chrono::duration<double, nano>>(Time::now() - start).count();
+        if (r < warmup)
+            continue;
+        allocated += allocations - before;
+        samples.push_back(elapsed / batch);
+    }
+    sort(samples.begin(), samples.end());
+    Result result;
+    result.kernel = kernel;
+    result.batch = batch;
+    result.median_ns = samples[samples.size() / 2];
+    result.p99_ns = samples[min(samples.size() - 1, static_cast<size_t>(0.99 * samples.size()))];
+    result.allocations_per_call = static_cast<double>(allocated) / (static_cast<double>(batch) * reps);
+    return result;
+}
+
+/*
+ * Benchmarks every kernel on one shape of a matrix.
+ */
+static void benchShape(const DistanceMatrix &matrix, int k, int p, int warmup, int reps, long long batch, vector<Result> &results)
+{
+    const int n = matrix.size();
+    const int t = n / (k * p);
+    BenchClimb climb(matrix, p, t, k, 1.0);
+    mt19937 rng(n + k * p);
+
+    State state;
+    climb.random_initialize(state);
+    climb.construct_session_matrix(state);
+
+    // Swaps between different sessions, as the searches propose them
+    vector<pair<int, int>> swaps(batch);
+    uniform_int_distribution<int> position(0, n - 1);
+    for (auto &swap : swaps)
+    {
+        do
+            swap = make_pair(position(rng), position(rng));
+        while (swap.first / k == swap.second / k);
+    }
+    vector<Move> moves(batch);
+    for (long long i = 0; i != batch; ++i)
+        moves[i] = climb.make_move(swaps[i].first, swaps[i].second, state);
+
+    volatile double sink = 0;
+    vector<Result> shape;
+    shape.push_back(measure("score_increment", batch, warmup, reps, [&]() {
+        double sum = 0;
+        for (const Move &move : moves)
+            sum += climb.score_increment(move);
+        sink = sink + sum;
+    }));
+    shape.push_back(measure("update_state", batch, warmup, reps, [&]() {
+        for (auto &swap : swaps)
+            climb.update_state(climb.make_move(swap.first, swap.second, state), state);
+    }));
+    if (t > 1)
+    {
+        uniform_int_distribution<int> session(0, p * t - 1);
+        vector<SessionMove> sessionMoves(batch);
+        for (auto &move : sessionMoves)
+        {
+            int a = session(rng), b;
+            do
+                b = session(rng);
+            while (a / p == b / p);
+            move = climb.make_session_move(a, b);
+        }
+        shape.push_back(measure("session_score_increment", batch, warmup, reps, [&]() {
+            double sum = 0;
+            for (const SessionMove &move : sessionMoves)
+                sum += climb.score_increment(move);
+            sink = sink + sum;
+        }));
+        long long sessionBatch = max(1LL, batch / 100); // each one moves whole aggregate rows
+        shape.push_back(measure("session_update_state", sessionBatch, warmup, reps, [&]() {
+            for (long long i = 0; i != sessionBatch; ++i)
+                climb.update_state(sessionMoves[i], state);
+        }));
+    }
+    shape.push_back(measure("construct_session_matrix", 1, warmup, reps, [&]() { climb.construct_session_matrix(state); }));
+    shape.push_back(measure("score", 1, warmup, reps, [&]() { sink = sink + climb.score(state); }));
+
+    for (Result &result : shape)
+    {
+        result.n = n;
+        result.k = k;
+        result.p = p;
+        result.t = t;
+        fprintf(stderr, "n=%-6d k=%-3d p=%-3d t=%-5d %-26s median %12.1f ns  p99 %12.1f ns  %14.0f /s  %.3g allocs\n", n, k, p, t,
+                result.kernel.c_str(), result.median_ns, result.p99_ns, 1e9 / result.median_ns, result.allocations_per_call);
+        results.push_back(result);
+    }
+}
+
+static void writeCsv(const string &filename, const vector<Result> &results)
+{
+    ofstream out(filename);
+    out << "n,k,p,t,kernel,batch,median_ns,p99_ns,calls_per_second,allocations_per_call\n";
+    for (const Result &r : results)
+        out << r.n << ',' << r.k << ',' << r.p << ',' << r.t << ',' << r.kernel << ',' << r.batch << ',' << r.median_ns << ','
+            << r.p99_ns << ',' << 1e9 / r.median_ns << ',' << r.allocations_per_call << '\n';
+}
+
+static void writeJson(const string &filename, const vector<Result> &results)
+{
+    ofstream out(filename);
+    out << "{\n  \"isa\": \"" << kernels().isa << "\",\n  \"results\": [";
+    for (size_t i = 0; i != results.size(); ++i)
+    {
+        const Result &r = results[i];
+        out << (i ? ",\n" : "\n") << "    {\"n\": " << r.n << ", \"k\": " << r.k << ", \"p\": " << r.p << ", \"t\": " << r.t
+            << ", \"kernel\": \"" << r.kernel << "\", \"batch\": " << r.batch << ", \"median_ns\": " << r.median_ns
+            << ", \"p99_ns\": " << r.p99_ns << ", \"calls_per_second\": " << 1e9 / r.median_ns
+            << ", \"allocations_per_call\": " << r.allocations_per_call << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+/*
+ * Reads a comma separated list of integers.
+ */
+static vector<int> parseList(const char *text)
+{
+    vector<int> values;
+    stringstream in(text);
+    string item;
+    while (getline(in, item, ','))
+        values.push_back(atoi(item.c_str()));
+    return values;
+}
+
+/*
+ * Throughput of the search kernels over a grid of problem sizes n and
+ * shapes (k papers per session, p parallel tracks, t = n / (k p) slots)
+ * on random matrices. Shapes that do not divide n or would need more than
+ * the memory limit are skipped.
+ */
+int main(int argc, char **argv)
+{
+    vector<int> sizes = {100, 1000, 5000, 20000};
+    vector<int> shapes = {5, 2, 10, 4, 20, 5}; // (k, p) pairs
+    int warmup = 3, reps = 31;
+    long long batch = 10000;
+    double memoryLimit = 4096; // MiB
+    MatrixFormat format;
+    string csvFile, jsonFile;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--sizes") == 0 && i + 1 < argc)
+        {
+            sizes = parseList(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--shapes") == 0 && i + 1 < argc && parseList(argv[i + 1]).size() % 2 == 0)
+        {
+            shapes = parseList(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+        {
+            warmup = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc)
+        {
+            reps = max(1, atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc)
+        {
+            batch = max(1LL, atoll(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--memory") == 0 && i + 1 < argc)
+        {
+            memoryLimit = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--precision") == 0 && i + 1 < argc && parse_element_type(argv[i + 1], format.element))
+        {
+            i++;
+        }
+        else if (strcmp(argv[i], "--triangle") == 0)
+        {
+            format.layout = LAYOUT_UPPER_TRIANGLE;
+        }
+        else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc)
+        {
+            csvFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+        {
+            jsonFile = argv[++i];
+        }
+        else
+        {
+            cout << "Unknown argument " << argv[i] << endl;
+            cout << "./bench [--sizes N,N,...] [--shapes K,P,K,P,...] [--warmup N] [--reps N] [--batch N] [--memory MIB]"
+                 << " [--precision double|float|fixed16] [--triangle] [--csv FILE] [--json FILE]";
+            exit(0);
+        }
+    }
+
+    fprintf(stderr, "kernels: %s\n", kernels().isa);
+    vector<Result> results;
+    for (int n : sizes)
+    {
+        double matrixBytes = static_cast<double>(n) * DistanceMatrix::padded_stride(n, format.element) *
+                             (format.element == ELEMENT_DOUBLE ? 8 : format.element == ELEMENT_FLOAT ? 4 : 2);
+        if (format.layout == LAYOUT_UPPER_TRIANGLE)
+            matrixBytes /= 2;
+        if (matrixBytes / (1 << 20) > memoryLimit)
+        {
+            fprintf(stderr, "n=%-6d skipped, the matrix needs %.0f MiB\n", n, matrixBytes / (1 << 20));
+            continue;
+        }
+
+        DistanceMatrix matrix = randomMatrix(n, format);
+        for (size_t s = 0; s + 1 < shapes.size(); s += 2)
+        {
+            int k = shapes[s], p = shapes[s + 1];
+            if (k <= 0 || p <= 0 || n % (k * p))
+                continue;
+            // Session, slot and session pair aggregates
+            double sessions = n / k;
+            double aggregates = 8 * (sessions * n + static_cast<double>(n) / (k * p) * n + sessions * sessions);
+            if ((matrixBytes + aggregates) / (1 << 20) > memoryLimit)
+            {
+                fprintf(stderr, "n=%-6d k=%-3d p=%-3d skipped, needs %.0f MiB\n", n, k, p, (matrixBytes + aggregates) / (1 << 20));
+                continue;
+            }
+            benchShape(matrix, k, p, warmup, reps, batch, results);
+        }
+    }
+
+    if (!csvFile.empty())
+        writeCsv(csvFile, results);
+    if (!jsonFile.empty())
+        writeJson(jsonFile, results);
+    return 0;
+}
@@ -0,0 +1,382 @@
+/*
+ * File:   check.cpp
+ * Author: Varun Srivastava
+ *
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+
+#include "HillClimb.h"
+#include "MemeticSearch.h"
+#include "ParallelTempering.h"
+#include "SearchBudget.h"
+#include "SessionOrganizer.h"
+#include "TabuSearch.h"
+
+using namespace std;
+
+static int failures = 0;
+
+static void expect(bool condition, const string &what)
+{
+    if (!condition)
+    {
+        cout << "FAILED: " << what << endl;
+        ++failures;
+    }
+}
+
+/*
+ * Exposes the counters of a search.
+ */
+class CheckClimb : public HillClimb
+{
+  public:
+    using HillClimb::HillClimb;
+    using HillClimb::construct_session_matrix;
+    using HillClimb::score;
+    using HillClimb::stats;
+};
+
+class CheckTempering : public ParallelTempering
+{
+  public:
+    using ParallelTempering::ParallelTempering;
+    using ParallelTempering::stats;
+};
+
+class CheckTabu : public TabuSearch
+{
+  public:
+    using TabuSearch::TabuSearch;
+    using TabuSearch::stats;
+};
+
+/*
+ * Moves a budget lets run when asked one move at a time.
+ */
+static long long countMoves(const SearchOptions &options)
+{
+    SearchBudget budget(Time::now() + chrono::hours(1), options);
+    long long moves = 0;
+    while (budget.next())
+        ++moves;
+    expect(budget.get_iterations() == moves, "the budget counts the moves that ran, not the one refused");
+    return moves;
+}
+
+/*
+ * Moves a budget lets run when charged in batches after the fact, as
+ * searches that spread their moves over helper threads do.
+ */
+static long long countBatches(const SearchOptions &options, long long batch)
+{
+    SearchBudget budget(Time::now() + chrono::hours(1), options);
+    long long moves = 0;
+    while (budget.next(moves ? batch : 0))
+        moves += batch;
+    return moves;
+}
+
+static void checkBudget()
+{
+    for (long long n : {1LL, 2LL, 299LL, 300LL, 2000LL})
+    {
+        SearchOptions fixed;
+        fixed.max_iterations = n;
+        fixed.fixed_iterations = true;
+        expect(countMoves(fixed) == n, "--fixed-iterations " + to_string(n) + " runs exactly that many moves");
+
+        SearchOptions limited;
+        limited.max_iterations = n;
+        expect(countMoves(limited) == n, "--iterations " + to_string(n) + " runs exactly that many moves");
+    }
+
+    SearchOptions none;
+    none.fixed_iterations = true;
+    expect(countMoves(none) == 0, "--fixed-iterations 0 runs no move");
+
+    SearchOptions fixed;
+    fixed.max_iterations = 1000;
+    fixed.fixed_iterations = true;
+    expect(countBatches(fixed, 100) == 1000, "batches of moves stop at the limit");
+}
+
+/*
+ * Small symmetric matrix of k * p * t papers the engines are run on.
+ */
+static void fillMatrix(DistanceMatrix &matrix)
+{
+    const int n = matrix.size();
+    for (int i = 0; i < n; ++i)
+        for (int j = 0; j < n; ++j)
+            matrix.row(i)[j] = i == j ? 0 : ((i * 7 + j * 7 + (i * j) % 5) % 10) / 10.0;
+}
+
+static void checkEngine()
+{
+    const int k = 3, p = 2, t = 4, n = k * p * t;
+    DistanceMatrix matrix(n);
+    fillMatrix(matrix);
+
+    // Tabu charges the swaps of a whole step, so it may end at most one neighbourhood past the limit
+    const long long neighbourhood = static_cast<long long>(n) * (n - 1) / 2 - static_cast<long long>(n) * (k - 1) / 2;
+    SearchOptions steps;
+    steps.max_iterations = 2000;
+    steps.fixed_iterations = true;
+    CheckTabu tabu(matrix, p, t, k, 1.0, 1);
+    tabu.hill_climb(true, 1, 43, 1, steps);
+    expect(tabu.stats.evaluated >= 2000 && tabu.stats.evaluated < 2000 + neighbourhood,
+           "tabu counts evaluated swaps against --fixed-iterations, evaluated " + to_string(tabu.stats.evaluated));
+
+    // Rounds of 1000 moves per replica, the last one cut short
+    for (long long moves : {2500LL, 20000LL, 21234LL})
+    {
+        SearchOptions rounds;
+        rounds.max_iterations = moves;
+        rounds.fixed_iterations = true;
+        CheckTempering tempering(matrix, p, t, k, 1.0, 4, 1);
+        tempering.hill_climb(true, 1, 43, 1, rounds);
+        expect(tempering.stats.evaluated == moves, "tempering evaluates exactly --fixed-iterations " + to_string(moves) +
+                                                        " moves, evaluated " + to_string(tempering.stats.evaluated));
+    }
+
+    SearchOptions options;
+    options.max_iterations = 2000;
+    options.fixed_iterations = true;
+    CheckClimb climb(matrix, p, t, k, 1.0);
+    climb.hill_climb(true, 1, 43, 1, options);
+    expect(climb.stats.evaluated == 2000, "hill climb evaluates exactly --fixed-iterations moves, evaluated " +
+                                              to_string(climb.stats.evaluated));
+}
+
+/*
+ * Timed searches have to end by their deadline. A search that runs on past
+ * it, possibly for good, fails the check and ends the program.
+ */
+static void checkDeadline()
+{
+    const int k = 3, p = 2, t = 4, n = k * p * t;
+    DistanceMatrix matrix(n);
+    fillMatrix(matrix);
+
+    const double seconds = 0.2, slack = 2.0;
+    for (int seed = 0; seed != 5; ++seed)
+    {
+        atomic<bool> finished(false);
+        thread run([&]() {
+            MemeticSearch memetic(matrix, p, t, k, 1.0, 2, 1);
+            memetic.hill_climb(true, seconds / 60, seed, 1);
+            finished = true;
+        });
+        const auto deadline = Time::now() + chrono::duration<double>(seconds + slack);
+        while (!finished && Time::now() < deadline)
+            this_thread::sleep_for(chrono::milliseconds(10));
+        if (!finished)
+        {
+            cout << "FAILED: a " << seconds << " s memetic search with seed " << seed << " runs past its deadline" << endl;
+            _Exit(1);
+        }
+        run.join();
+    }
+}
+
+/*
+ * Feature vectors of 5 dimensions, with or without negative components.
+ */
+static void fillFeatures(DistanceMatrix &features, bool negative)
+{
+    for (int i = 0; i < features.size(); ++i)
+        for (int j = 0; j < features.get_dimensions(); ++j)
+            features.features(i)[j] = ((i * 3 + j * 5 + i * j) % 7) / 7.0f - (negative ? 0.4f : 0.0f);
+    features.finish_features();
+}
+
+/*
+ * Every kind of matrix scores a swap or a session move with the change of
+ * the score computed from scratch.
+ */
+static void checkIncrements(const DistanceMatrix &matrix, const string &name)
+{
+    const int k = 3, p = 2, t = 4, n = k * p * t;
+    CheckClimb climb(matrix, p, t, k, 1.5);
+    default_random_engine rng(7);
+    State state(n);
+    iota(state.begin(), state.end(), 0);
+    shuffle(state.begin(), state.end(), rng);
+    climb.construct_session_matrix(state);
+
+    double worst = 0;
+    for (int step = 0; step < 400; ++step)
+    {
+        const double before = climb.score(state);
+        double increment;
+        if (step % 4 == 3)
+        {
+            SessionMove move = climb.make_session_move(rng() % (p * t), rng() % (p * t));
+            increment = climb.score_increment(move);
+            climb.update_state(move, state);
+        }
+        else
+        {
+            Move move = climb.make_move(rng() % n, rng() % n, state);
+            increment = climb.score_increment(move);
+            climb.update_state(move, state);
+        }
+        worst = max(worst, fabs(climb.score(state) - before - increment));
+    }
+    expect(worst < 1e-9, name + " moves change the score by their increment, off by " + to_string(worst));
+}
+
+static void checkAllIncrements()
+{
+    const int k = 3, p = 2, t = 4, n = k * p * t;
+    DistanceMatrix dense(n);
+    fillMatrix(dense);
+    checkIncrements(dense, "dense");
+
+    vector<vector<Neighbour>> neighbours(n);
+    for (int i = 0; i < n; ++i)
+    {
+        neighbours[i].push_back(Neighbour{(i + 1) % n, (i % 5) / 10.0});
+        neighbours[i].push_back(Neighbour{(i * 5 + 3) % n, 0.3});
+    }
+    DistanceMatrix sparse(n, 0.7, neighbours);
+    checkIncrements(sparse, "sparse");
+
+    DistanceMatrix linear(n, 5, METRIC_COSINE), cosine(n, 5, METRIC_COSINE), euclidean(n, 5, METRIC_EUCLIDEAN);
+    fillFeatures(linear, false);
+    fillFeatures(cosine, true);
+    fillFeatures(euclidean, true);
+    expect(!cosine.is_linear() && !euclidean.is_linear(), "features with negative components are not linear");
+    checkIncrements(linear, "linear feature");
+    checkIncrements(cosine, "cosine feature");
+    checkIncrements(euclidean, "euclidean feature");
+}
+
+/*
+ * Reads a neighbours input of four papers, two tracks of one session of two
+ * papers, and returns what is wrong with it or an empty string.
+ */
+static string readNeighbours(const string &neighbours, double &distance)
+{
+    const char *filename = "build/check_neighbours.txt";
+    {
+        ofstream file(filename);
+        file << "0.1\n2\n1\n2\n1\n" << neighbours;
+    }
+    string error;
+    SessionOrganizer organizer(filename, 1, MatrixFormat(), &error);
+    remove(filename);
+    if (error.empty())
+        distance = organizer.getDistanceMatrix()(0, 3);
+    return error;
+}
+
+static void checkNeighbours()
+{
+    vector<vector<Neighbour>> lists(4);
+    lists[0] = {Neighbour{1, 0.6}, Neighbour{2, 0.2}};
+    lists[1] = {Neighbour{0, 0.4}};
+    lists[2] = {Neighbour{0, 0.5}};
+    DistanceMatrix sparse(4, 0.9, lists);
+    expect(sparse(0, 1) == 0.4 && sparse(1, 0) == 0.4, "a pair listed twice keeps the smaller distance");
+    expect(sparse(0, 2) == 0.2 && sparse(2, 0) == 0.2, "a pair listed twice keeps the smaller distance either way");
+    expect(sparse(0, 3) == 0.9 && sparse(3, 2) == 0.9, "unlisted pairs have the default distance");
+    expect(sparse(1, 1) == 0, "a paper has no distance to itself");
+
+    double distance = -1;
+    expect(readNeighbours("neighbours 0.7\n1 0.2\n0 0.2 2 0.5\n1 0.5 3 0.1\n2 0.1\n", distance).empty() && distance == 0.7,
+           "a valid neighbours input reads with the default distance for unlisted pairs");
+    expect(readNeighbours("neighbours 0.7\n1 0.2\n0 0.2 2 0.5\n\n\n", distance).empty(), "papers may have no neighbours");
+
+    const string malformed = "The neighbours of paper 1 are not pairs of a paper and a distance between 0 and 1.";
+    for (const char *line : {"4 0.2", "-1 0.2", "0.5 0.2", "2 1.5", "2 -0.1", "2 nan", "2", "2 x"})
+        expect(readNeighbours(string("neighbours 0.7\n\n") + line + "\n\n\n", distance) == malformed,
+               string("the neighbours \"") + line + "\" are rejected");
+
+    const string header = "The neighbours line has to be: neighbours <default distance between 0 and 1>";
+    for (const char *line : {"neighbours 1.5", "neighbours -0.5", "neighbours nan", "neighbours"})
+        expect(readNeighbours(string(line) + "\n\n\n\n\n", distance) == header,
+               string("the header \"") + line + "\" is rejected");
+}
+
+/*
+ * A cosine input without negative components is searched with summed feature
+ * vectors instead of the dense aggregates, both have to score every move alike.
+ */
+static void checkFeatureSums()
+{
+    const int k = 3, p = 2, t = 4, n = k * p * t;
+    DistanceMatrix features(n, 5, METRIC_COSINE);
+    fillFeatures(features, false);
+    expect(features.is_linear(), "non-negative cosine features are linear");
+
+    DistanceMatrix dense(n);
+    vector<double> buffer(n);
+    for (int i = 0; i < n; ++i)
+    {
+        const double *row = features.row(i, buffer.data());
+        copy(row, row + n, dense.row(i));
+    }
+
+    CheckClimb summed(features, p, t, k, 1.5), full(dense, p, t, k, 1.5);
+    State state(n);
+    iota(state.begin(), state.end(), 0);
+    summed.construct_session_matrix(state);
+    full.construct_session_matrix(state);
+    for (int step = 0; step < 50; ++step)
+    {
+        double worst = 0;
+        for (int a = 0; a < n; ++a)
+            for (int b = 0; b < n; ++b)
+                worst = max(worst, fabs(summed.score_increment(a, b, state) - full.score_increment(a, b, state)));
+        for (int a = 0; a < p * t; ++a)
+            for (int b = 0; b < p * t; ++b)
+                worst = max(worst, fabs(summed.score_increment(summed.make_session_move(a, b)) -
+                                        full.score_increment(full.make_session_move(a, b))));
+        expect(worst < 1e-12, "summed features score moves like the dense aggregates, off by " + to_string(worst));
+
+        // Both keep their sums up to date through swaps and session moves
+        State copy = state;
+        if (step % 3 == 2)
+        {
+            summed.update_state(summed.make_session_move(step % (p * t), (step * 5 + p) % (p * t)), state);
+            full.update_state(full.make_session_move(step % (p * t), (step * 5 + p) % (p * t)), copy);
+        }
+        else
+        {
+            summed.update_state(step % n, (step * 7 + 5) % n, state);
+            full.update_state(step % n, (step * 7 + 5) % n, copy);
+        }
+    }
+}
+
+/*
+ * Checks of the search budget and the engines that count moves with it, and
+ * of the aggregates the engines score moves with.
+ */
+int main()
+{
+    checkBudget();
+    checkEngine();
+    checkDeadline();
+    checkAllIncrements();
+    checkNeighbours();
+    checkFeatureSums();
+    if (failures)
+        return 1;
+    cout << "All checks passed" << endl;
+    return 0;
+}
@@ -0,0 +1,54 @@
+/* 
+ * File:   convert.cpp
+ * Author: Varun Srivastava
+ *
+ */
+
+#include <cstdlib>
+#include <cstring>
+
+#include "SessionOrganizer.h"
+
+using namespace std;
+
+/*
+ * Converts a text input file into the binary format main maps directly.
+ */
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        cout << "Missing arguments\n";
+        cout << "Correct format : \n";
+        cout << "./convert <input_filename> <binary_filename> [--threads N] [--precision double|float|fixed16] [--triangle]";
+        exit(0);
+    }
+
+    int threads = 1;
+    MatrixFormat format;
+    for (int i = 3; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--precision") == 0 && i + 1 < argc && parse_element_type(argv[i + 1], format.element))
+        {
+            i++;
+        }
+        else if (strcmp(argv[i], "--triangle") == 0)
+        {
+            format.layout = LAYOUT_UPPER_TRIANGLE;
+        }
+        else
+        {
+            cout << "Unknown argument " << argv[i] << endl;
+            exit(0);
+        }
+    }
+
+    SessionOrganizer organizer(argv[1], threads, format);
+    organizer.writeBinaryFile(argv[2]);
+
+    return 0;
+}
@@ -0,0 +1,346 @@
+/*
+ * File:   generate.cpp
+ * Author: Varun Srivastava
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "BinaryMatrix.h"
+#include "WorkerPool.h"
+
+using namespace std;
+
+/*
+ * Parameters of a synthetic instance. Every session of the planted
+ * schedule is a topic: papers of the same topic are `close` apart and
+ * papers of different topics `far`, both with uniform noise of +- noise.
+ * Distances are rounded to `digits` decimals so that the text file, the
+ * binary file and the planted score agree exactly.
+ */
+struct Instance
+{
+    int k, p, t;
+    double minutes, tradeoff;
+    double close, far, noise;
+    int digits;
+    uint64_t seed;
+
+    vector<int> topic; // planted session of every paper
+};
+
+// Rows every worker produces per round, bounds the memory in flight
+static const int ROWS_PER_BLOCK = 64;
+
+/*
+ * Uniform value in [0, 1) that only depends on the unordered pair and the
+ * seed, so that rows can be generated independently and stay symmetric.
+ */
+static double pairNoise(uint64_t seed, int i, int j)
+{
+    uint64_t x = seed ^ (static_cast<uint64_t>(min(i, j)) << 32 | static_cast<uint64_t>(max(i, j)));
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return (x >> 11) * (1.0 / (1ULL << 53));
+}
+
+/*
+ * Row i of the distance matrix.
+ */
+static void distanceRow(const Instance &instance, int i, double *row)
+{
+    const int n = instance.topic.size();
+    const double scale = pow(10.0, instance.digits);
+    for (int j = 0; j != n; ++j)
+    {
+        if (i == j)
+        {
+            row[j] = 0;
+            continue;
+        }
+        double base = instance.topic[i] == instance.topic[j] ? instance.close : instance.far;
+        double d = base + instance.noise * (2 * pairNoise(instance.seed, i, j) - 1);
+        row[j] = round(min(1.0, max(0.0, d)) * scale) / scale;
+    }
+}
+
+/*
+ * Contribution of row i to the score of the planted schedule, from the
+ * pairs (i, j) with j > i.
+ */
+static double plantedScore(const Instance &instance, int i, const double *row)
+{
+    const int n = instance.topic.size();
+    double score = 0;
+    for (int j = i + 1; j != n; ++j)
+    {
+        int a = instance.topic[i], b = instance.topic[j];
+        if (a == b)
+            score += 1 - row[j];
+        else if (a / instance.p == b / instance.p)
+            score += instance.tradeoff * row[j];
+    }
+    return score;
+}
+
+/*
+ * Appends value, in [0, 1], with the given number of decimals. Much faster
+ * than printf for the n^2 values of a large instance.
+ */
+static void appendDistance(string &out, double value, int digits, uint64_t scale)
+{
+    uint64_t q = llround(value * scale);
+    if (q >= scale)
+    {
+        out += '1';
+        return;
+    }
+    if (q == 0)
+    {
+        out += '0';
+        return;
+    }
+    char text[24];
+    text[0] = '0';
+    text[1] = '.';
+    for (int d = digits; d != 0; --d)
+    {
+        text[1 + d] = '0' + q % 10;
+        q /= 10;
+    }
+    int length = 2 + digits;
+    while (text[length - 1] == '0')
+        --length;
+    out.append(text, length);
+}
+
+/*
+ * Writes the planted schedule in the format of the organizer's output.
+ */
+static void writePlanted(const Instance &instance, const string &filename)
+{
+    const int n = instance.topic.size();
+    vector<vector<int>> sessions(instance.p * instance.t);
+    for (int x = 0; x != n; ++x)
+        sessions[instance.topic[x]].push_back(x);
+
+    ofstream out(filename.c_str());
+    for (int slot = 0; slot != instance.t; ++slot)
+    {
+        for (int track = 0; track != instance.p; ++track)
+        {
+            for (int paper : sessions[slot * instance.p + track])
+                out << paper << " ";
+            if (track != instance.p - 1)
+                out << "| ";
+        }
+        out << "\n";
+    }
+}
+
+/*
+ * Generates a conference instance with a planted schedule of known score,
+ * a lower bound on the optimum that searches can be measured against,
+ * as text in the readInInputFile format or in the binary format. Rows are
+ * generated by a pool of threads a block at a time and streamed to disk,
+ * so memory does not grow with n^2.
+ */
+int main(int argc, char **argv)
+{
+    if (argc < 5)
+    {
+        cout << "Missing arguments\n";
+        cout << "Correct format : \n";
+        cout << "./generate <output_filename> <k> <p> <t> [--time MINUTES] [--tradeoff C] [--close D] [--far D]"
+             << " [--noise D] [--digits N] [--seed N] [--threads N] [--binary] [--precision double|float|fixed16]"
+             << " [--triangle] [--planted FILE]";
+        exit(0);
+    }
+
+    Instance instance;
+    instance.k = atoi(argv[2]);
+    instance.p = atoi(argv[3]);
+    instance.t = atoi(argv[4]);
+    instance.minutes = 1;
+    instance.tradeoff = 1;
+    instance.close = 0.2;
+    instance.far = 0.8;
+    instance.noise = 0.1;
+    instance.digits = 4;
+    instance.seed = 43;
+    int threads = 1;
+    bool binary = false;
+    MatrixFormat format;
+    string plantedFile;
+    for (int i = 5; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--time") == 0 && i + 1 < argc)
+        {
+            instance.minutes = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--tradeoff") == 0 && i + 1 < argc)
+        {
+            instance.tradeoff = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--close") == 0 && i + 1 < argc)
+        {
+            instance.close = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--far") == 0 && i + 1 < argc)
+        {
+            instance.far = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--noise") == 0 && i + 1 < argc)
+        {
+            instance.noise = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--digits") == 0 && i + 1 < argc)
+        {
+            instance.digits = min(15, max(1, atoi(argv[++i])));
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            instance.seed = strtoull(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--binary") == 0)
+        {
+            binary = true;
+        }
+        else if (strcmp(argv[i], "--precision") == 0 && i + 1 < argc && parse_element_type(argv[i + 1], format.element))
+        {
+            i++;
+        }
+        else if (strcmp(argv[i], "--triangle") == 0)
+        {
+            format.layout = LAYOUT_UPPER_TRIANGLE;
+        }
+        else if (strcmp(argv[i], "--planted") == 0 && i + 1 < argc)
+        {
+            plantedFile = argv[++i];
+        }
+        else
+        {
+            cout << "Unknown argument " << argv[i] << endl;
+            exit(0);
+        }
+    }
+    if (instance.k <= 0 || instance.p <= 0 || instance.t <= 0)
+    {
+        cout << "k, p and t have to be positive" << endl;
+        exit(0);
+    }
+
+    // Topics are dealt to a shuffled order of the papers so the structure is not visible in the numbering
+    const int n = instance.k * instance.p * instance.t;
+    vector<int> order(n);
+    iota(order.begin(), order.end(), 0);
+    mt19937_64 rng(instance.seed);
+    shuffle(order.begin(), order.end(), rng);
+    instance.topic.resize(n);
+    for (int i = 0; i != n; ++i)
+        instance.topic[order[i]] = i / instance.k;
+
+    unique_ptr<BinaryMatrixWriter> writer;
+    ofstream text;
+    if (binary)
+    {
+        writer.reset(new BinaryMatrixWriter(argv[1], n, format, instance.minutes, instance.k, instance.p, instance.t, instance.tradeoff));
+        if (!writer->is_open())
+        {
+            cout << "Unable to write " << argv[1] << endl;
+            exit(0);
+        }
+    }
+    else
+    {
+        text.open(argv[1]);
+        if (!text)
+        {
+            cout << "Unable to write " << argv[1] << endl;
+            exit(0);
+        }
+        text << instance.minutes << "\n"
+             << instance.k << "\n"
+             << instance.p << "\n"
+             << instance.t << "\n"
+             << instance.tradeoff << "\n";
+    }
+
+    // Each round every worker turns one block of rows into bytes, which are then written in row order
+    WorkerPool pool(max(1, threads));
+    const int workers = pool.size();
+    const uint64_t scale = llround(pow(10.0, instance.digits));
+    vector<string> blocks(workers);
+    vector<double> scores(workers), errors(workers, 0.0);
+    vector<vector<double>> rows(workers, vector<double>(n));
+    double score = 0, error = 0;
+    for (int first = 0; first < n; first += workers * ROWS_PER_BLOCK)
+    {
+        pool.run([&](int w) {
+            string &block = blocks[w];
+            block.clear();
+            scores[w] = 0;
+            int begin = min(n, first + w * ROWS_PER_BLOCK), end = min(n, begin + ROWS_PER_BLOCK);
+            for (int i = begin; i < end; ++i)
+            {
+                double *row = rows[w].data();
+                distanceRow(instance, i, row);
+                scores[w] += plantedScore(instance, i, row);
+                if (writer)
+                {
+                    size_t at = block.size();
+                    block.resize(at + writer->row_bytes(i));
+                    errors[w] = max(errors[w], writer->encode_row(i, row, &block[at]));
+                    continue;
+                }
+                for (int j = 0; j != n; ++j)
+                {
+                    if (j)
+                        block += ' ';
+                    appendDistance(block, row[j], instance.digits, scale);
+                }
+                block += '\n';
+            }
+        });
+        for (int w = 0; w != workers; ++w)
+        {
+            if (writer)
+                writer->write(blocks[w].data(), blocks[w].size());
+            else
+                text.write(blocks[w].data(), blocks[w].size());
+            score += scores[w];
+        }
+    }
+    for (double e : errors)
+        error = max(error, e);
+
+    bool written = writer ? writer->finish(error) : (text.close(), !text.fail());
+    if (!written)
+    {
+        cout << "Unable to write " << argv[1] << endl;
+        exit(0);
+    }
+    if (!plantedFile.empty())
+        writePlanted(instance, plantedFile);
+    cout << "planted score: " << fixed << setprecision(6) << score << endl;
+    return 0;
+}
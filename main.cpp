@@ -5,31 +5,227 @@
  */
 
 #include <cstdlib>
+#include <cstring>
+#include <sstream>
 
 #include "SessionOrganizer.h"
+#include "SolverService.h"
 
 using namespace std;
 
+/*
+ * Reads a comma separated list of paper numbers.
+ */
+static vector<int> parsePaperList(const char *text)
+{
+    vector<int> papers;
+    stringstream in(text);
+    string item;
+    while (getline(in, item, ','))
+        papers.push_back(atoi(item.c_str()));
+    return papers;
+}
+
+/*
+ * Runs the solver service until it is asked to shut down.
+ */
+static int serve(int argc, char **argv)
+{
+    int threads = 1;
+    int cacheSize = SolverService::DEFAULT_CACHE_SIZE;
+    int rowCache = 0;
+    for (int i = 3; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc)
+        {
+            cacheSize = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--row-cache") == 0 && i + 1 < argc)
+        {
+            rowCache = atoi(argv[++i]);
+        }
+        else
+        {
+            cout << "Unknown argument " << argv[i] << endl;
+            exit(0);
+        }
+    }
+    SolverService service(argv[2], threads, cacheSize, rowCache);
+    if (!service.run())
+    {
+        cout << "Unable to listen on " << argv[2] << endl;
+        exit(0);
+    }
+    return 0;
+}
+
 /*
  * 
  */
 int main(int argc, char **argv)
 {
+    if (argc >= 3 && strcmp(argv[1], "--serve") == 0)
+        return serve(argc, argv);
+
     // Parse the input.
     if (argc < 3)
     {
         cout << "Missing arguments\n";
         cout << "Correct format : \n";
-        cout << "./main <input_filename> <output_filename>";
+        cout << "./main <input_filename> <output_filename> [--threads N] [--precision double|float|fixed16] [--triangle]"
+             << " [--iterations N] [--fixed-iterations N] [--target SCORE] [--check-every N]"
+             << " [--engine hillclimb|anneal|tabu|tempering|memetic] [--cooling geometric|adaptive|reheat]"
+             << " [--init random|greedy] [--replicas N] [--islands N] [--trace FILE] [--verify]"
+             << " [--warm-start ORGANIZATION] [--withdraw PAPER,PAPER,...] [--max-moved N]"
+             << " [--checkpoint FILE] [--checkpoint-every SECONDS] [--resume] [--row-cache N]\n";
+        cout << "./main --serve <socket> [--threads N] [--cache N] [--row-cache N]";
         exit(0);
     }
     string inputfilename(argv[1]);
 
-    // Initialize the conference organizer.
-    SessionOrganizer *organizer = new SessionOrganizer(inputfilename);
+    int threads = 1;
+    MatrixFormat format;
+    SearchOptions options;
+    SearchEngine engine = ENGINE_HILL_CLIMB;
+    CoolingSchedule cooling = COOLING_GEOMETRIC;
+    bool greedy = false;
+    int replicas = 0;
+    int islands = 0;
+    string warmStart;
+    vector<int> withdrawn;
+    int maxMoved = -1;
+    int rowCache = 0;
+    for (int i = 3; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--precision") == 0 && i + 1 < argc && parse_element_type(argv[i + 1], format.element))
+        {
+            i++;
+        }
+        else if (strcmp(argv[i], "--triangle") == 0)
+        {
+            format.layout = LAYOUT_UPPER_TRIANGLE;
+        }
+        else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+        {
+            options.max_iterations = atoll(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--fixed-iterations") == 0 && i + 1 < argc)
+        {
+            options.max_iterations = atoll(argv[++i]);
+            options.fixed_iterations = true;
+        }
+        else if (strcmp(argv[i], "--target") == 0 && i + 1 < argc)
+        {
+            options.target_score = atof(argv[++i]);
+            options.has_target = true;
+        }
+        else if (strcmp(argv[i], "--check-every") == 0 && i + 1 < argc)
+        {
+            options.check_interval = atoll(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--engine") == 0 && i + 1 < argc && parse_search_engine(argv[i + 1], engine))
+        {
+            i++;
+        }
+        else if (strcmp(argv[i], "--init") == 0 && i + 1 < argc && (strcmp(argv[i + 1], "random") == 0 || strcmp(argv[i + 1], "greedy") == 0))
+        {
+            greedy = strcmp(argv[++i], "greedy") == 0;
+        }
+        else if (strcmp(argv[i], "--replicas") == 0 && i + 1 < argc)
+        {
+            replicas = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+        {
+            options.trace_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--verify") == 0)
+        {
+            options.verify_scores = true;
+        }
+        else if (strcmp(argv[i], "--warm-start") == 0 && i + 1 < argc)
+        {
+            warmStart = argv[++i];
+        }
+        else if (strcmp(argv[i], "--withdraw") == 0 && i + 1 < argc)
+        {
+            withdrawn = parsePaperList(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--max-moved") == 0 && i + 1 < argc)
+        {
+            maxMoved = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc)
+        {
+            options.checkpoint_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--checkpoint-every") == 0 && i + 1 < argc)
+        {
+            options.checkpoint_period = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--resume") == 0)
+        {
+            options.resume = true;
+        }
+        else if (strcmp(argv[i], "--row-cache") == 0 && i + 1 < argc)
+        {
+            rowCache = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--islands") == 0 && i + 1 < argc)
+        {
+            islands = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--cooling") == 0 && i + 1 < argc && parse_cooling_schedule(argv[i + 1], cooling))
+        {
+            i++;
+        }
+        else
+        {
+            cout << "Unknown argument " << argv[i] << endl;
+            exit(0);
+        }
+    }
+
+    if (options.checkpoint_period <= 0)
+    {
+        cout << "--checkpoint-every needs a positive number of seconds" << endl;
+        exit(0);
+    }
+    if (options.resume && options.checkpoint_file.empty())
+    {
+        cout << "--resume needs the --checkpoint file to resume from" << endl;
+        exit(0);
+    }
+
+    // Initialize the conference organizer, text and binary (./convert) inputs are told apart by their header.
+    SessionOrganizer *organizer = new SessionOrganizer(inputfilename, threads, format);
+    if (organizer->scoreErrorBound() > 0)
+    {
+        cout << "Score error bound from stored distance precision: " << organizer->scoreErrorBound() << endl;
+    }
+    organizer->setRowCache(rowCache);
+    organizer->setSearchOptions(options);
+    organizer->setEngine(engine, cooling);
+    organizer->setGreedyInitialization(greedy);
+    organizer->setReplicas(replicas);
+    organizer->setIslands(islands);
+    organizer->setWarmStart(warmStart, withdrawn, maxMoved);
 
     // Organize the papers into tracks based on similarity.
     organizer->organizePapers();
+    if (!warmStart.empty())
+    {
+        const SearchStats &stats = organizer->getSearchStats();
+        cout << "Warm start: placed " << stats.placed << " papers, moved " << stats.moved << " papers" << endl;
+    }
 
     organizer->printSessionOrganiser(argv[2]);
 
@@ -0,0 +1,50 @@
+/* 
+ * File:   score.cpp
+ * Author: Varun Srivastava
+ *
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "SessionOrganizer.h"
+
+using namespace std;
+
+/*
+ * Scores an organization file against an input file, text or binary.
+ */
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        cout << "Missing arguments\n";
+        cout << "Correct format : \n";
+        cout << "./score <input_filename> <organization_filename> [--threads N]";
+        exit(0);
+    }
+
+    int threads = 1;
+    for (int i = 3; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            threads = atoi(argv[++i]);
+        }
+        else
+        {
+            cout << "Unknown argument " << argv[i] << endl;
+            exit(0);
+        }
+    }
+
+    SessionOrganizer organizer(argv[1], threads);
+    organizer.readOrganization(argv[2]);
+    printf("%.6f\n", organizer.scoreOrganization());
+    if (organizer.scoreErrorBound() > 0)
+    {
+        cout << "Score error bound from stored distance precision: " << organizer.scoreErrorBound() << endl;
+    }
+    return 0;
+}